@@ -1,264 +1,251 @@
 // FAST OPTIMIZED HYBRID CPU - RV64GC + x86-64
 // Modularized and optimized for better performance and readability
+//
+// Two independent cores (hybrid_rv_core, hybrid_x86_core) fetch through one
+// shared memory arbiter. In the default handoff mode exactly one core runs:
+// 0xDEADBEEF stops the RISC-V core and starts the x86 core at pc+4. With
+// boot_concurrent set, both cores run every cycle from reset and 0xDEADBEEF
+// only redirects the x86 core.
+//
+// The RISC-V core is pipelined; its branch predictor is a parameter here so
+// predictor designs can be compared from the build (-GRV_BP_SCHEME=N, make BP=...).
+// The L1 caches in front of the guest memory are configured the same way.
+// Both cores reach the console UART through the arbiter's data port, and each
+// has a `VEC_VLEN-bit SIMD unit (RISC-V V subset / x86 SSE subset).
+// WFI parks the RISC-V core until reset and HLT parks the x86 core until the
+// next 0xDEADBEEF; rv_idle/x86_idle and the L1I geometry outputs let the host
+// fast-forward parked and NOP-sled stretches exactly (time_warp.h).
 
 `include "rv_constants.vh"
 `include "x86_constants.vh"
+`include "mem_constants.vh"
+`include "simd_constants.vh"
 
-module RV64GC_optimized (
+module RV64GC_optimized #(
+    parameter RV_BP_SCHEME = `BP_GSHARE,  // `BP_STATIC, `BP_BIMODAL or `BP_GSHARE
+    parameter RV_BP_INDEX_BITS = 7,
+    parameter L1I_SIZE = `L1_DEFAULT_SIZE,      // Bytes
+    parameter L1I_WAYS = `L1_DEFAULT_WAYS,
+    parameter L1I_LINE = `L1_DEFAULT_LINE,      // Bytes per line
+    parameter L1I_REPL = `CACHE_REPL_LRU,       // `CACHE_REPL_LRU, `CACHE_REPL_FIFO or `CACHE_REPL_RANDOM
+    parameter L1D_SIZE = `L1_DEFAULT_SIZE,
+    parameter L1D_WAYS = `L1_DEFAULT_WAYS,
+    parameter L1D_LINE = `L1_DEFAULT_LINE,
+    parameter L1D_REPL = `CACHE_REPL_LRU,
+    parameter MEM_MISS_LATENCY = `MEM_DEFAULT_MISS_LATENCY, // Backing memory cycles per refill
+    parameter CONSOLE_TX_CYCLES = `CONSOLE_DEFAULT_TX_CYCLES // UART cycles per byte to the host
+) (
     input clk,
     input rst,
     
     // RISC-V outputs
-    output reg [63:0] pc,
-    output reg [63:0] reg_out,
-    output reg [31:0] debug_instr,
-    output reg [6:0] debug_opcode,
-    output reg [4:0] debug_rd,
-    output reg [4:0] debug_rs1,
-    output reg [63:0] debug_imm,
-    output reg [63:0] debug_alu_result,
+    output [63:0] pc,
+    output [63:0] reg_out,
+    output [31:0] debug_instr,        // Instruction of the x86 core while it runs, else RISC-V
+    output [6:0] debug_opcode,
+    output [4:0] debug_rd,
+    output [4:0] debug_rs1,
+    output [63:0] debug_imm,
+    output [63:0] debug_alu_result,
     
     // x86 outputs (optimized)
-    output reg [63:0] x86_rip,
-    output reg [63:0] x86_rflags,
-    output wire [63:0] x86_rax,
-    output wire [63:0] x86_rcx,
-    output wire [63:0] x86_rdx,
-    output wire [63:0] x86_rbx,
-    output reg [1:0] x86_mode,
-    output reg x86_long_mode,
-    output reg x86_cf, x86_zf, x86_sf, x86_of
+    output [63:0] x86_rip,
+    output [63:0] x86_rflags,
+    output [63:0] x86_rax,
+    output [63:0] x86_rcx,
+    output [63:0] x86_rdx,
+    output [63:0] x86_rbx,
+    output [1:0] x86_mode,
+    output x86_long_mode,
+    output x86_cf, x86_zf, x86_sf, x86_of,
+    
+    // Performance counters (mcycle/minstret style, cleared on reset)
+    output reg [63:0] mcycle /*verilator public_flat_rw*/,
+    output [63:0] minstret,           // Both cores; up to 2 per cycle in concurrent mode
+    output [63:0] rv_mcycle,
+    output [63:0] rv_minstret,
+    output [63:0] x86_mcycle,
+    output [63:0] x86_minstret,
+    output [63:0] perf_mode_switches,
+    output [63:0] perf_unknown_skips,
+    output [63:0] rv_unknown_skips,
+    output [63:0] x86_unknown_skips,
+    output rv_idle,                   // Parked in WFI
+    output x86_idle,                  // Parked in HLT
+    output [63:0] rv_idle_cycles,
+    output [63:0] x86_idle_cycles,
+    
+    // RISC-V pipeline counters
+    output [1:0] rv_bp_scheme,        // RV_BP_SCHEME this model was built with
+    output [63:0] rv_stall_cycles,
+    output [63:0] rv_flushes,
+    output [63:0] rv_branches,
+    output [63:0] rv_mispredicts,
+    
+    // L1 cache statistics (the L1I is shared by both fetch ports)
+    output [31:0] l1i_lines,          // L1I geometry this model was built with
+    output [31:0] l1i_line_bytes,
+    output [1:0] l1i_repl,
+    output [63:0] l1i_hits,
+    output [63:0] l1i_misses,
+    output [63:0] l1i_evictions,
+    output [63:0] l1d_hits,
+    output [63:0] l1d_misses,
+    output [63:0] l1d_evictions,
+    
+    // Console UART statistics
+    output [63:0] console_tx_bytes,
+    output [63:0] console_overruns,
+    
+    // SIMD counters per core (lane utilization: simd_lane_active in each core)
+    output [63:0] rv_simd_ops,
+    output [63:0] rv_simd_elements,
+    output [63:0] x86_simd_ops,
+    output [63:0] x86_simd_elements,
+    
+    // Retirement trace ports, one per core (describe the last clock's retirement)
+    output rv_retire_valid,
+    output [63:0] rv_retire_pc,
+    output [31:0] rv_retire_instr,
+    output rv_retire_wen,
+    output [4:0] rv_retire_rd,
+    output [63:0] rv_retire_value,
+    output x86_retire_valid,
+    output [63:0] x86_retire_pc,
+    output [31:0] x86_retire_instr,
+    output x86_retire_wen,
+    output [4:0] x86_retire_rd,
+    output [63:0] x86_retire_value
 );
 
-    // === REGISTER FILES (Optimized) ===
-    reg [63:0] regs [0:31];           // RISC-V integer registers
-    reg [63:0] fregs [0:31];          // RISC-V floating-point registers  
-    reg [63:0] x86_regs [0:15];       // x86 general-purpose registers
+    // === BOOT CONFIGURATION (written by C++ program loaders before reset) ===
+    reg [63:0] boot_pc /*verilator public_flat_rw*/;
+    reg [63:0] boot_rip /*verilator public_flat_rw*/;
+    reg [63:0] boot_rflags /*verilator public_flat_rw*/;
+    reg boot_x86_mode /*verilator public_flat_rw*/;
+    reg boot_concurrent /*verilator public_flat_rw*/;  // Run both cores every cycle
+    
+    // === EXECUTION STATE ===
+    reg rv_mode_active /*verilator public*/;   // RISC-V core enabled
+    reg x86_mode_active /*verilator public*/;  // x86 core enabled
     
-    // Optimized x86 register access
-    assign x86_rax = x86_regs[0];
-    assign x86_rcx = x86_regs[1]; 
-    assign x86_rdx = x86_regs[2];
-    assign x86_rbx = x86_regs[3];
+    // === INTERCONNECT ===
+    wire rv_fetch_req, rv_fetch_commit, rv_fetch_ready;
+    wire x86_fetch_req, x86_fetch_commit, x86_fetch_ready;
+    wire [63:0] rv_fetch_addr, x86_fetch_addr;
+    wire [31:0] rv_fetch_data, x86_fetch_data;
+    wire rv_data_req, rv_data_we;
+    wire [4:0] rv_data_bytes;
+    wire [63:0] rv_data_addr;
+    wire [`VEC_VLEN-1:0] rv_data_wdata;
+    wire x86_data_req, x86_data_we;
+    wire [4:0] x86_data_bytes;
+    wire [63:0] x86_data_addr;
+    wire [`VEC_VLEN-1:0] x86_data_wdata;
+    wire [`VEC_VLEN-1:0] data_rdata;
+    wire rv_data_gnt, x86_data_gnt;
+    wire start_x86;
+    wire [63:0] start_x86_rip;
+    wire [31:0] rv_debug_instr, x86_debug_instr;
+    wire [63:0] rv_mode_switches;
     
-    // === MEMORY (Optimized sizes) ===
-    reg [31:0] instr_mem [0:127];     // Reduced from 256 to 128
-    reg [7:0] data_mem [0:511];       // Reduced from 1024 to 512
+    assign debug_instr = x86_mode_active ? x86_debug_instr : rv_debug_instr;
+    assign minstret = rv_minstret + x86_minstret;
+    assign perf_mode_switches = rv_mode_switches;
+    assign perf_unknown_skips = rv_unknown_skips + x86_unknown_skips;
+    assign rv_bp_scheme = RV_BP_SCHEME;
+    assign l1i_lines = L1I_SIZE / L1I_LINE;
+    assign l1i_line_bytes = L1I_LINE;
+    assign l1i_repl = L1I_REPL;
     
-    // === CONTROL SIGNALS (Consolidated) ===
-    reg [2:0] funct3;
-    reg [6:0] funct7;
-    reg [63:0] rs1_data, rs2_data, alu_result;
-    reg [3:0] alu_op;
-    reg mem_read, mem_write, reg_write;
+    // === SHARED MEMORY ===
+    hybrid_mem_arbiter #(
+        .L1I_SIZE(L1I_SIZE), .L1I_WAYS(L1I_WAYS), .L1I_LINE(L1I_LINE), .L1I_REPL(L1I_REPL),
+        .L1D_SIZE(L1D_SIZE), .L1D_WAYS(L1D_WAYS), .L1D_LINE(L1D_LINE), .L1D_REPL(L1D_REPL),
+        .MISS_LATENCY(MEM_MISS_LATENCY), .CONSOLE_TX_CYCLES(CONSOLE_TX_CYCLES)
+    ) mem (
+        .clk(clk), .rst(rst),
+        .rv_fetch_req(rv_fetch_req), .rv_fetch_commit(rv_fetch_commit),
+        .rv_fetch_addr(rv_fetch_addr), .rv_fetch_data(rv_fetch_data), .rv_fetch_ready(rv_fetch_ready),
+        .x86_fetch_req(x86_fetch_req), .x86_fetch_commit(x86_fetch_commit),
+        .x86_fetch_addr(x86_fetch_addr), .x86_fetch_data(x86_fetch_data), .x86_fetch_ready(x86_fetch_ready),
+        .rv_data_req(rv_data_req), .rv_data_we(rv_data_we), .rv_data_bytes(rv_data_bytes),
+        .rv_data_addr(rv_data_addr), .rv_data_wdata(rv_data_wdata), .rv_data_gnt(rv_data_gnt),
+        .x86_data_req(x86_data_req), .x86_data_we(x86_data_we), .x86_data_bytes(x86_data_bytes),
+        .x86_data_addr(x86_data_addr), .x86_data_wdata(x86_data_wdata), .x86_data_gnt(x86_data_gnt),
+        .data_rdata(data_rdata),
+        .l1i_hits(l1i_hits), .l1i_misses(l1i_misses), .l1i_evictions(l1i_evictions),
+        .l1d_hits(l1d_hits), .l1d_misses(l1d_misses), .l1d_evictions(l1d_evictions),
+        .console_tx_bytes(console_tx_bytes), .console_overruns(console_overruns)
+    );
     
-    // === EXECUTION STATE ===
-    reg x86_mode_active;
-    reg [3:0] execution_stage;
+    // === RISC-V CORE ===
+    hybrid_rv_core #(.BP_SCHEME(RV_BP_SCHEME), .BP_INDEX_BITS(RV_BP_INDEX_BITS)) rv_core (
+        .clk(clk), .rst(rst), .run(rv_mode_active), .handoff(!boot_concurrent), .boot_pc(boot_pc),
+        .fetch_req(rv_fetch_req), .fetch_commit(rv_fetch_commit),
+        .fetch_addr(rv_fetch_addr), .fetch_data(rv_fetch_data), .fetch_ready(rv_fetch_ready),
+        .data_req(rv_data_req), .data_we(rv_data_we), .data_bytes(rv_data_bytes),
+        .data_addr(rv_data_addr), .data_wdata(rv_data_wdata), .data_gnt(rv_data_gnt), .data_rdata(data_rdata),
+        .start_x86(start_x86), .start_x86_rip(start_x86_rip),
+        .pc(pc), .reg_out(reg_out), .debug_instr(rv_debug_instr),
+        .debug_opcode(debug_opcode), .debug_rd(debug_rd), .debug_rs1(debug_rs1),
+        .debug_imm(debug_imm), .debug_alu_result(debug_alu_result), .idle(rv_idle),
+        .mcycle(rv_mcycle), .minstret(rv_minstret),
+        .mode_switches(rv_mode_switches), .unknown_skips(rv_unknown_skips), .idle_cycles(rv_idle_cycles),
+        .stall_cycles(rv_stall_cycles), .flushes(rv_flushes), .branches(rv_branches), .mispredicts(rv_mispredicts),
+        .simd_ops(rv_simd_ops), .simd_elements(rv_simd_elements),
+        .retire_valid(rv_retire_valid), .retire_pc(rv_retire_pc), .retire_instr(rv_retire_instr),
+        .retire_wen(rv_retire_wen), .retire_rd(rv_retire_rd), .retire_value(rv_retire_value)
+    );
     
-    // === INITIALIZATION (Optimized) ===
+    // === x86 CORE ===
+    hybrid_x86_core x86_core (
+        .clk(clk), .rst(rst), .run(x86_mode_active), .boot_rip(boot_rip), .boot_rflags(boot_rflags),
+        .start(start_x86), .start_rip(start_x86_rip),
+        .fetch_req(x86_fetch_req), .fetch_commit(x86_fetch_commit),
+        .fetch_addr(x86_fetch_addr), .fetch_data(x86_fetch_data), .fetch_ready(x86_fetch_ready),
+        .data_req(x86_data_req), .data_we(x86_data_we), .data_bytes(x86_data_bytes),
+        .data_addr(x86_data_addr), .data_wdata(x86_data_wdata), .data_gnt(x86_data_gnt), .data_rdata(data_rdata),
+        .x86_rip(x86_rip), .x86_rflags(x86_rflags),
+        .x86_rax(x86_rax), .x86_rcx(x86_rcx), .x86_rdx(x86_rdx), .x86_rbx(x86_rbx),
+        .x86_mode(x86_mode), .x86_long_mode(x86_long_mode),
+        .x86_cf(x86_cf), .x86_zf(x86_zf), .x86_sf(x86_sf), .x86_of(x86_of),
+        .debug_instr(x86_debug_instr), .idle(x86_idle),
+        .mcycle(x86_mcycle), .minstret(x86_minstret), .unknown_skips(x86_unknown_skips),
+        .idle_cycles(x86_idle_cycles),
+        .simd_ops(x86_simd_ops), .simd_elements(x86_simd_elements),
+        .retire_valid(x86_retire_valid), .retire_pc(x86_retire_pc), .retire_instr(x86_retire_instr),
+        .retire_wen(x86_retire_wen), .retire_rd(x86_retire_rd), .retire_value(x86_retire_value)
+    );
+    
+    // === INITIALIZATION ===
     initial begin
-        // Fast initialization using generate blocks would be better
-        // but keeping simple for compatibility
+        mcycle = 0;
         
-        // RISC-V state
-        pc = 0;
-        reg_out = 0;
-        debug_instr = 0;
+        // Default boot: RISC-V at 0, x86 entry at the classic 0x400000
+        boot_pc = 0;
+        boot_rip = 64'h400000;
+        boot_rflags = 64'h202;  // IF=1, Reserved=1
+        boot_x86_mode = 0;
+        boot_concurrent = 0;
         
-        // x86 state  
-        x86_rip = 64'h400000;
-        x86_rflags = 64'h202;  // IF=1, Reserved=1
-        x86_mode = 2'b10;      // Long mode
-        x86_long_mode = 1;
+        rv_mode_active = 1;
         x86_mode_active = 0;
-        
-        // Initialize key registers with interesting FAST values
-        x86_regs[0] = 64'h1234567890ABCDEF; // RAX - FAST signature!
-        x86_regs[1] = 64'hBEEFCAFE12345678; // RCX 
-        x86_regs[2] = 64'hDEADBEEF87654321; // RDX
-        x86_regs[3] = 64'hCAFEBABE13579BDF; // RBX
-        
-        // Optimized test program (reduced size)
-        load_fast_boy_program();
     end
     
-    // === OPTIMIZED PROGRAM LOADER ===
-    task load_fast_boy_program;
-        begin
-            // Essential RISC-V instructions only
-            instr_mem[0]  = 32'h00100093; // ADDI x1,x0,1
-            instr_mem[1]  = 32'h00200113; // ADDI x2,x0,2  
-            instr_mem[2]  = 32'h002081b3; // ADD x3,x1,x2
-            instr_mem[3]  = 32'h0020c3b3; // XOR x7,x1,x2
-            instr_mem[4]  = 32'h002083b3; // MUL x7,x1,x2 (RV64M)
-            
-            // FAST MODE SWITCH!
-            instr_mem[5]  = 32'hDEADBEEF; // MAGIC FAST SWITCH!
-            
-            // Essential x86 instructions
-            instr_mem[6]  = 32'h48C7C001; // MOV RAX, 1 (x86-64)
-            instr_mem[7]  = 32'h48C7C102; // MOV RCX, 2
-            instr_mem[8]  = 32'h4801C8;   // ADD RAX, RCX
-            instr_mem[9]  = 32'h90;       // NOP
-            
-            // Fill rest with NOPs
-            for (integer i = 10; i < 128; i = i + 1) begin
-                instr_mem[i] = 32'h00000013; // RISC-V NOP
-            end
-        end
-    endtask
-    
-    // === MAIN EXECUTION (Optimized Pipeline) ===
+    // === CORE ENABLES ===
     always @(posedge clk or posedge rst) begin
         if (rst) begin
-            fast_boy_reset();
+            rv_mode_active <= boot_concurrent || !boot_x86_mode;
+            x86_mode_active <= boot_concurrent || boot_x86_mode;
+            mcycle <= 0;
         end else begin
-            if (x86_mode_active) begin
-                execute_x86_fast();
-            end else begin
-                execute_riscv_fast();
+            mcycle <= mcycle + 1;
+            if (start_x86) begin
+                x86_mode_active <= 1;
+                if (!boot_concurrent) rv_mode_active <= 0; // Handoff: RISC-V core parks
             end
         end
     end
-    
-    // === FAST RESET ===
-    task fast_boy_reset;
-        begin
-            pc <= 0;
-            reg_out <= 0;
-            x86_mode_active <= 0;
-            execution_stage <= 0;
-            // Registers stay initialized from initial block
-        end
-    endtask
-    
-    // === OPTIMIZED RISC-V EXECUTION ===
-    task execute_riscv_fast;
-        reg [31:0] instr;
-        begin
-            // Fetch (optimized)
-            instr = instr_mem[pc[8:2]]; // Direct indexing, no masking overhead
-            
-            // Decode + Execute (combined for speed)
-            case (instr)
-                32'hDEADBEEF: begin // FAST MODE SWITCH!
-                    x86_mode_active <= 1;
-                    x86_rip <= pc + 4;
-                    pc <= pc + 4; // Continue execution in x86 mode
-                end
-                
-                default: begin
-                    case (instr[6:0])
-                        7'b0010011: begin // I-type (ADDI, etc.)
-                            fast_alu_op(instr);
-                            pc <= pc + 4;
-                        end
-                        
-                        7'b0110011: begin // R-type (ADD, XOR, MUL, etc.)
-                            fast_alu_op(instr);
-                            pc <= pc + 4;
-                        end
-                        
-                        default: begin
-                            pc <= pc + 4; // Skip unknown instructions
-                        end
-                    endcase
-                end
-            endcase
-            
-            // Update debug outputs
-            debug_instr <= instr;
-            debug_opcode <= instr[6:0];
-            debug_rd <= instr[11:7];
-            debug_rs1 <= instr[19:15];
-        end
-    endtask
-    
-    // === OPTIMIZED x86 EXECUTION ===
-    task execute_x86_fast;
-        reg [31:0] instr;
-        begin
-            // Simplified x86 execution for FAST mode
-            instr = instr_mem[x86_rip[8:2]];
-            
-            // Basic x86 decode (simplified for performance)
-            case (instr[7:0])
-                8'h48: begin // REX.W prefix - 64-bit operation
-                    fast_x86_alu(instr);
-                    x86_rip <= x86_rip + 4; // Simplified length
-                end
-                
-                8'h90: begin // NOP  
-                    x86_rip <= x86_rip + 1;
-                end
-                
-                default: begin
-                    x86_rip <= x86_rip + 1; // Skip unknown
-                end
-            endcase
-            
-            // Update x86 flags (simplified)
-            update_x86_flags();
-        end
-    endtask
-    
-    // === FAST ALU OPERATIONS ===
-    task fast_alu_op;
-        input [31:0] instr;
-        reg [4:0] rd, rs1, rs2;
-        reg [63:0] imm;
-        begin
-            rd = instr[11:7];
-            rs1 = instr[19:15];
-            rs2 = instr[24:20];
-            imm = {{52{instr[31]}}, instr[31:20]};
-            
-            case ({instr[31:25], instr[14:12]})
-                10'b0000000000: regs[rd] <= regs[rs1] + imm; // ADDI
-                10'b0000000100: regs[rd] <= regs[rs1] ^ imm; // XORI  
-                10'b0000000000: regs[rd] <= regs[rs1] + regs[rs2]; // ADD (R-type)
-                10'b0000001000: regs[rd] <= regs[rs1] * regs[rs2]; // MUL
-                default: regs[rd] <= regs[rs1]; // Default case
-            endcase
-            
-            if (rd != 0) reg_out <= regs[rd]; // x0 is always 0
-        end
-    endtask
-    
-    // === FAST x86 ALU ===  
-    task fast_x86_alu;
-        input [31:0] instr;
-        begin
-            // Simplified x86 ALU for FAST operations
-            case (instr[15:8])
-                8'hC7: begin // MOV immediate
-                    case (instr[18:16]) // ModR/M reg field
-                        3'b000: x86_regs[0] <= {32'h0, instr[31:16]}; // RAX
-                        3'b001: x86_regs[1] <= {32'h0, instr[31:16]}; // RCX
-                        default: x86_regs[0] <= {32'h0, instr[31:16]};
-                    endcase
-                end
-                
-                8'h01: begin // ADD reg, reg
-                    x86_regs[0] <= x86_regs[0] + x86_regs[1]; // RAX += RCX
-                end
-            endcase
-        end
-    endtask
-    
-    // === FAST x86 FLAGS UPDATE ===
-    task update_x86_flags;
-        begin
-            // Simplified flag update for FAST mode
-            x86_zf <= (x86_regs[0] == 0);
-            x86_sf <= x86_regs[0][63];
-            x86_cf <= 0; // Simplified
-            x86_of <= 0; // Simplified
-            
-            // Pack into RFLAGS
-            x86_rflags <= {52'h0, x86_of, 3'h0, x86_sf, x86_zf, 1'b0, 1'b0, 1'b0, x86_cf, 1'b1};
-        end
-    endtask
 
 endmodule
@@ -0,0 +1,519 @@
+// FAST Hybrid CPU - headless batch runner
+// Runs many independent guest jobs across a worker pool, one VerilatedContext per worker.
+//
+// Usage: batch_runner [-j workers] [-o results.jsonl]
+//                     [--checkpoint-every N] [--checkpoint-dir dir]
+//                     [--trace-dir dir] [--profile-dir dir] [--profile-every N]
+//                     [--console-dir dir] [--concurrent] [--huge-pages] [--time-warp]
+//                     <jobs-file | ->
+//
+// -j defaults to one worker per host core, divided by the model's Verilator
+// threads (THREADS at build time); larger values are capped to that.
+//
+// Jobs file: one job per line, "<program> <cycles>", '#' starts a comment.
+// <program> is "builtin" (the demo program baked into the RTL), an ELF64 image,
+// a flat binary loaded at address 0 (prefix "x86:" to start it in x86 mode),
+// or "ckpt:<file>" to resume from a saved checkpoint.
+//
+// --trace-dir writes a compressed retired-instruction trace per job
+// (job<N>.trace), readable with trace_analyzer. --profile-dir samples the guest
+// PC every --profile-every cycles and writes job<N>.profile.txt (flat profile)
+// and job<N>.folded (flamegraph input). --console-dir saves each job's guest
+// console output as job<N>.console (otherwise it is only counted).
+// --concurrent boots every job with both cores running every cycle. Each job
+// gets its own sparse guest memory; --huge-pages backs it with 2 MiB pages.
+// --time-warp fast-forwards idle (WFI/HLT) and NOP-sled stretches with exact
+// counters (see time_warp.h); traced jobs always tick every cycle.
+
+#include "checkpoint.h"
+#include "hybrid_model.h"
+#include "instr_trace.h"
+#include "pc_profiler.h"
+#include "program_loader.h"
+#include "time_warp.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Host threads each model evaluates on (the Makefile passes its THREADS)
+#ifndef HYBRID_MODEL_THREADS
+#define HYBRID_MODEL_THREADS 1
+#endif
+static const unsigned MODEL_THREADS = HYBRID_MODEL_THREADS;
+
+struct BatchJob {
+    std::string program;
+    uint64_t cycles;
+};
+
+struct BatchResult {
+    CpuState state;
+    PerfCounters perf;
+    uint64_t start_cycle;
+    uint64_t cycles;
+    double wall_seconds;
+    uint64_t trace_records;
+    uint64_t trace_bytes;
+    uint64_t profile_samples;
+    uint64_t memory_pages;   // Guest pages touched
+    uint64_t memory_bytes;   // Host bytes backing them
+    double tlb_hit_rate;
+    uint64_t console_bytes;  // Guest console output
+    uint64_t console_flushes; // Host writes it took
+    uint64_t warped_cycles;  // Cycles the time warp skipped instead of ticking
+    uint64_t warps;
+    std::string error;
+};
+
+// Run cycles, appending every retired instruction to the trace (RISC-V
+// first when both cores retire in the same cycle)
+static void run_cycles_traced(VRV64GC_optimized* cpu, uint64_t cycles, TraceWriter& trace) {
+    TraceRecord record;
+    for (uint64_t i = 0; i < cycles; i++) {
+        tick(cpu);
+        if (cpu->rv_retire_valid) {
+            record.pc = cpu->rv_retire_pc;
+            record.instr = cpu->rv_retire_instr;
+            record.x86 = false;
+            record.write = cpu->rv_retire_wen;
+            record.rd = cpu->rv_retire_rd;
+            record.value = cpu->rv_retire_value;
+            trace.append(record);
+        }
+        if (cpu->x86_retire_valid) {
+            record.pc = cpu->x86_retire_pc;
+            record.instr = cpu->x86_retire_instr;
+            record.x86 = true;
+            record.write = cpu->x86_retire_wen;
+            record.rd = cpu->x86_retire_rd;
+            record.value = cpu->x86_retire_value;
+            trace.append(record);
+        }
+    }
+}
+
+class BatchRunner {
+private:
+    const std::vector<BatchJob>& jobs;
+    std::vector<BatchResult> results;
+    std::atomic<size_t> next_job;
+    unsigned workers;
+    uint64_t checkpoint_every;
+    std::string checkpoint_dir;
+    std::string trace_dir;   // Empty = tracing off
+    std::string profile_dir; // Empty = profiling off
+    uint64_t profile_every;
+    bool concurrent;
+    std::string console_dir; // Empty = console output only counted
+    bool huge_pages;
+    bool time_warp;
+
+public:
+    BatchRunner(const std::vector<BatchJob>& job_list, unsigned worker_count,
+                uint64_t checkpoint_interval = 0, const std::string& checkpoint_path = ".",
+                const std::string& trace_path = "", bool concurrent_cores = false,
+                const std::string& profile_path = "", uint64_t profile_period = PROFILE_DEFAULT_PERIOD,
+                bool use_huge_pages = false, const std::string& console_path = "", bool use_time_warp = false)
+        : jobs(job_list), results(job_list.size()), next_job(0), workers(worker_count),
+          checkpoint_every(checkpoint_interval), checkpoint_dir(checkpoint_path), trace_dir(trace_path),
+          profile_dir(profile_path), profile_every(profile_period), concurrent(concurrent_cores),
+          console_dir(console_path), huge_pages(use_huge_pages), time_warp(use_time_warp) {}
+
+    void run() {
+        std::vector<std::thread> pool;
+        pool.reserve(workers);
+        for (unsigned i = 0; i < workers; i++) {
+            pool.emplace_back(&BatchRunner::worker_loop, this);
+        }
+        for (auto& t : pool) t.join();
+    }
+
+    const std::vector<BatchResult>& get_results() const { return results; }
+
+private:
+    void worker_loop() {
+        // Each worker owns its context so models never share simulation state
+        std::unique_ptr<VerilatedContext> context(new VerilatedContext);
+
+        for (;;) {
+            size_t index = next_job.fetch_add(1, std::memory_order_relaxed);
+            if (index >= jobs.size()) break;
+            run_job(context.get(), index, results[index]);
+        }
+    }
+
+    void run_job(VerilatedContext* context, size_t index, BatchResult& result) {
+        result.start_cycle = 0;
+        result.cycles = 0;
+        result.wall_seconds = 0;
+        result.trace_records = 0;
+        result.trace_bytes = 0;
+        result.profile_samples = 0;
+        result.memory_pages = 0;
+        result.memory_bytes = 0;
+        result.tlb_hit_rate = 0;
+        result.console_bytes = 0;
+        result.console_flushes = 0;
+        result.warped_cycles = 0;
+        result.warps = 0;
+
+        int console_fd = -1;
+        if (!console_dir.empty()) {
+            std::string path = console_dir + "/job" + std::to_string(index) + ".console";
+            console_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (console_fd < 0) {
+                result.error = "cannot create " + path;
+                return;
+            }
+        }
+        run_model(context, index, result, console_fd);
+        if (console_fd >= 0) close(console_fd);
+    }
+
+    // One job on a fresh model; console output goes to console_fd (-1 = counted only)
+    void run_model(VerilatedContext* context, size_t index, BatchResult& result, int console_fd) {
+        const BatchJob& job = jobs[index];
+        auto start_time = std::chrono::steady_clock::now();
+
+        // Fresh model and memory per job so every run starts from the RTL initial state
+        SymbolTable symbols;
+        GuestMemory memory(huge_pages);
+        GuestConsole console(console_fd);
+        std::unique_ptr<VRV64GC_optimized> cpu(new VRV64GC_optimized(context));
+        attach_memory(cpu.get(), &memory);
+        attach_console(cpu.get(), &console);
+        set_concurrent(cpu.get(), concurrent); // Checkpoints carry their own setting
+        if (job.program == "builtin") {
+            load_builtin_program(cpu.get());
+        } else if (job.program.compare(0, 5, "ckpt:") == 0) {
+            if (!restore_checkpoint(cpu.get(), job.program.c_str() + 5, result.start_cycle, result.error)) {
+                cpu->final();
+                return;
+            }
+        } else {
+            bool raw_x86 = job.program.compare(0, 4, "x86:") == 0;
+            std::string path = raw_x86 ? job.program.substr(4) : job.program;
+            ProgramInfo info;
+            if (!load_program(cpu.get(), path.c_str(), info, result.error, raw_x86)) {
+                cpu->final();
+                return;
+            }
+            if (!profile_dir.empty() && !symbols.load(path.c_str(), result.error)) {
+                cpu->final();
+                return;
+            }
+        }
+
+        std::unique_ptr<TraceWriter> trace;
+        if (!trace_dir.empty()) {
+            trace.reset(new TraceWriter);
+            std::string path = trace_dir + "/job" + std::to_string(index) + ".trace";
+            if (!trace->open(path.c_str(), result.error)) {
+                cpu->final();
+                return;
+            }
+        }
+        std::unique_ptr<PcProfiler> profiler;
+        if (!profile_dir.empty()) profiler.reset(new PcProfiler(profile_every, &symbols));
+
+        // The warp replays counters, not retired instructions, so traces disable it
+        std::unique_ptr<TimeWarp> warp;
+        if (time_warp && !trace) warp.reset(new TimeWarp(cpu.get()));
+
+        auto run_span = [&](uint64_t cycles) {
+            if (trace) run_cycles_traced(cpu.get(), cycles, *trace);
+            else if (warp) warp->run(cycles);
+            else run_cycles(cpu.get(), cycles);
+        };
+        auto advance = [&](uint64_t cycles) {
+            if (profiler) profiler->run(cpu.get(), cycles, run_span);
+            else run_span(cycles);
+        };
+
+        if (!checkpoint_every) {
+            advance(job.cycles);
+        } else {
+            // Snapshot on absolute cycle boundaries so resumed jobs line up
+            uint64_t cycle = result.start_cycle;
+            uint64_t end_cycle = result.start_cycle + job.cycles;
+            while (cycle < end_cycle) {
+                uint64_t next = std::min(end_cycle, (cycle / checkpoint_every + 1) * checkpoint_every);
+                advance(next - cycle);
+                cycle = next;
+                if (cycle % checkpoint_every == 0) {
+                    std::string path = checkpoint_dir + "/job" + std::to_string(index) +
+                                       "_c" + std::to_string(cycle) + ".ckpt";
+                    if (!save_checkpoint(cpu.get(), path.c_str(), cycle, result.error)) {
+                        cpu->final();
+                        return;
+                    }
+                }
+            }
+        }
+
+        if (trace) {
+            if (!trace->close()) result.error = "trace write failed";
+            result.trace_records = trace->records();
+            result.trace_bytes = trace->bytes_written();
+        }
+        if (profiler) {
+            std::string prefix = profile_dir + "/job" + std::to_string(index);
+            if (!profiler->write_reports(prefix)) result.error = "profile write failed";
+            result.profile_samples = profiler->samples();
+        }
+
+        result.cycles = job.cycles;
+        result.state = capture_state(cpu.get());
+        result.perf = capture_counters(cpu.get());
+        result.memory_pages = memory.page_count();
+        result.memory_bytes = memory.resident_bytes();
+        result.tlb_hit_rate = hit_rate(memory.tlb_hits(), memory.tlb_misses());
+        console.flush();
+        result.console_bytes = console.bytes();
+        result.console_flushes = console.flushes();
+        if (warp) {
+            result.warped_cycles = warp->warped_cycles();
+            result.warps = warp->warps();
+        }
+        cpu->final();
+
+        auto end_time = std::chrono::steady_clock::now();
+        result.wall_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    }
+};
+
+static bool parse_jobs(std::istream& in, std::vector<BatchJob>& jobs) {
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        BatchJob job;
+        if (!(fields >> job.program)) continue; // Blank line
+        if (!(fields >> job.cycles)) {
+            std::cerr << "❌ jobs:" << line_no << ": expected '<program> <cycles>'\n";
+            return false;
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// String as a JSON string body: quotes, backslashes and control characters escaped
+static std::string json_escape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    return out;
+}
+
+static void write_result_json(FILE* out, size_t index, const BatchJob& job, const BatchResult& result) {
+    fprintf(out, "{\"job\":%zu,\"program\":\"%s\"", index, json_escape(job.program).c_str());
+    if (!result.error.empty()) {
+        fprintf(out, ",\"error\":\"%s\"}\n", json_escape(result.error).c_str());
+        return;
+    }
+
+    const CpuState& s = result.state;
+    double mhz = result.wall_seconds > 0 ? result.cycles / result.wall_seconds / 1e6 : 0;
+    fprintf(out, ",\"start_cycle\":%" PRIu64 ",\"cycles\":%" PRIu64 ",\"wall_s\":%.6f,\"mhz\":%.3f",
+            result.start_cycle, result.cycles, result.wall_seconds, mhz);
+    fprintf(out, ",\"pc\":\"0x%016" PRIx64 "\",\"x86_rip\":\"0x%016" PRIx64 "\",\"x86_mode\":%d",
+            s.pc, s.x86_rip, s.x86_mode ? 1 : 0);
+
+    fprintf(out, ",\"regs\":[");
+    for (int i = 0; i < 32; i++) fprintf(out, "%s\"0x%016" PRIx64 "\"", i ? "," : "", s.regs[i]);
+    fprintf(out, "],\"x86_regs\":[");
+    for (int i = 0; i < 16; i++) fprintf(out, "%s\"0x%016" PRIx64 "\"", i ? "," : "", s.x86_regs[i]);
+    fprintf(out, "]");
+
+    const PerfCounters& p = result.perf;
+    fprintf(out, ",\"counters\":{\"mcycle\":%" PRIu64 ",\"minstret\":%" PRIu64 ",\"rv_mcycle\":%" PRIu64
+                 ",\"rv_minstret\":%" PRIu64 ",\"x86_mcycle\":%" PRIu64 ",\"x86_minstret\":%" PRIu64
+                 ",\"mode_switches\":%" PRIu64 ",\"unknown_skips\":%" PRIu64
+                 ",\"rv_idle_cycles\":%" PRIu64 ",\"x86_idle_cycles\":%" PRIu64
+                 ",\"rv_stall_cycles\":%" PRIu64 ",\"rv_flushes\":%" PRIu64
+                 ",\"rv_branches\":%" PRIu64 ",\"rv_mispredicts\":%" PRIu64
+                 ",\"l1i_hits\":%" PRIu64 ",\"l1i_misses\":%" PRIu64 ",\"l1i_evictions\":%" PRIu64
+                 ",\"l1d_hits\":%" PRIu64 ",\"l1d_misses\":%" PRIu64 ",\"l1d_evictions\":%" PRIu64,
+            p.mcycle, p.minstret, p.rv_mcycle, p.rv_minstret, p.x86_mcycle, p.x86_minstret,
+            p.mode_switches, p.unknown_skips, p.rv_idle_cycles, p.x86_idle_cycles,
+            p.rv_stall_cycles, p.rv_flushes, p.rv_branches, p.rv_mispredicts,
+            p.l1i_hits, p.l1i_misses, p.l1i_evictions, p.l1d_hits, p.l1d_misses, p.l1d_evictions);
+    for (int c = 0; c < PERF_CLASS_COUNT; c++) {
+        if (perf_class_name(c)) fprintf(out, ",\"%s\":%" PRIu64, perf_class_name(c), p.class_retired[c]);
+    }
+    fprintf(out, "}");
+    if (result.trace_bytes) {
+        fprintf(out, ",\"trace\":{\"records\":%" PRIu64 ",\"bytes\":%" PRIu64 "}",
+                result.trace_records, result.trace_bytes);
+    }
+    fprintf(out, ",\"memory\":{\"pages\":%" PRIu64 ",\"bytes\":%" PRIu64 ",\"tlb_hit\":%.2f}",
+            result.memory_pages, result.memory_bytes, result.tlb_hit_rate);
+    if (p.rv_simd_ops || p.x86_simd_ops) {
+        fprintf(out, ",\"simd\":{\"rv_ops\":%" PRIu64 ",\"rv_elements\":%" PRIu64 ",\"x86_ops\":%" PRIu64
+                     ",\"x86_elements\":%" PRIu64 ",\"lane_active\":[",
+                p.rv_simd_ops, p.rv_simd_elements, p.x86_simd_ops, p.x86_simd_elements);
+        for (int lane = 0; lane < VEC_LANES; lane++) fprintf(out, "%s%" PRIu64, lane ? "," : "", p.simd_lane_active[lane]);
+        fprintf(out, "]}");
+    }
+    if (result.console_bytes || p.console_overruns) {
+        fprintf(out, ",\"console\":{\"bytes\":%" PRIu64 ",\"flushes\":%" PRIu64 ",\"overruns\":%" PRIu64 "}",
+                result.console_bytes, result.console_flushes, p.console_overruns);
+    }
+    if (result.warps) {
+        fprintf(out, ",\"time_warp\":{\"warped_cycles\":%" PRIu64 ",\"warps\":%" PRIu64 "}",
+                result.warped_cycles, result.warps);
+    }
+    if (result.profile_samples) fprintf(out, ",\"profile_samples\":%" PRIu64, result.profile_samples);
+    fprintf(out, "}\n");
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [-j workers] [-o results.jsonl]"
+              << " [--checkpoint-every N] [--checkpoint-dir dir] [--trace-dir dir]"
+              << " [--profile-dir dir] [--profile-every N] [--console-dir dir] [--concurrent] [--huge-pages]"
+              << " [--time-warp] <jobs-file | ->\n";
+}
+
+int main(int argc, char **argv) {
+    Verilated::commandArgs(argc, argv);
+
+    unsigned workers = std::max(1u, std::thread::hardware_concurrency() / MODEL_THREADS);
+    const char* jobs_path = nullptr;
+    const char* out_path = nullptr;
+    uint64_t checkpoint_every = 0;
+    std::string checkpoint_dir = ".";
+    std::string trace_dir;
+    std::string profile_dir;
+    std::string console_dir;
+    uint64_t profile_every = PROFILE_DEFAULT_PERIOD;
+    bool concurrent = false;
+    bool huge_pages = false;
+    bool time_warp = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            workers = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (!strcmp(argv[i], "--checkpoint-every") && i + 1 < argc) {
+            checkpoint_every = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--checkpoint-dir") && i + 1 < argc) {
+            checkpoint_dir = argv[++i];
+        } else if (!strcmp(argv[i], "--trace-dir") && i + 1 < argc) {
+            trace_dir = argv[++i];
+        } else if (!strcmp(argv[i], "--profile-dir") && i + 1 < argc) {
+            profile_dir = argv[++i];
+        } else if (!strcmp(argv[i], "--profile-every") && i + 1 < argc) {
+            profile_every = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--console-dir") && i + 1 < argc) {
+            console_dir = argv[++i];
+        } else if (!strcmp(argv[i], "--concurrent")) {
+            concurrent = true;
+        } else if (!strcmp(argv[i], "--huge-pages")) {
+            huge_pages = true;
+        } else if (!strcmp(argv[i], "--time-warp")) {
+            time_warp = true;
+        } else if (argv[i][0] == '+') {
+            // Verilator plusargs, already consumed by commandArgs
+        } else if (!jobs_path) {
+            jobs_path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!jobs_path) {
+        usage(argv[0]);
+        return 1;
+    }
+    // Every worker's model runs MODEL_THREADS evaluation threads; more workers
+    // than the host can hold only oversubscribes it
+    unsigned host_threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned max_workers = std::max(1u, host_threads / MODEL_THREADS);
+    if (workers > max_workers) {
+        std::cerr << "⚠️  " << workers << " workers x " << MODEL_THREADS << " model threads exceeds "
+                  << host_threads << " host threads, using " << max_workers << " workers"
+                  << " (rebuild with THREADS=1 for one job per core)\n";
+        workers = max_workers;
+    }
+    if (workers == 0) workers = 1;
+
+    std::vector<BatchJob> jobs;
+    bool parsed;
+    if (!strcmp(jobs_path, "-")) {
+        parsed = parse_jobs(std::cin, jobs);
+    } else {
+        std::ifstream jobs_file(jobs_path);
+        if (!jobs_file) {
+            std::cerr << "❌ Cannot open jobs file: " << jobs_path << "\n";
+            return 1;
+        }
+        parsed = parse_jobs(jobs_file, jobs);
+    }
+    if (!parsed) return 1;
+    if (workers > jobs.size() && !jobs.empty()) workers = static_cast<unsigned>(jobs.size());
+
+    FILE* out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        std::cerr << "❌ Cannot open output file: " << out_path << "\n";
+        return 1;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    BatchRunner runner(jobs, workers, checkpoint_every, checkpoint_dir, trace_dir, concurrent,
+                       profile_dir, profile_every, huge_pages, console_dir, time_warp);
+    runner.run();
+    auto end_time = std::chrono::steady_clock::now();
+    double elapsed_seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+    uint64_t total_cycles = 0;
+    size_t failed = 0;
+    const auto& results = runner.get_results();
+    for (size_t i = 0; i < jobs.size(); i++) {
+        write_result_json(out, i, jobs[i], results[i]);
+        total_cycles += results[i].cycles;
+        if (!results[i].error.empty()) failed++;
+    }
+    if (out != stdout) fclose(out);
+
+    double aggregate_mhz = elapsed_seconds > 0 ? total_cycles / elapsed_seconds / 1e6 : 0;
+    std::cerr << "📊 " << jobs.size() << " jobs (" << failed << " failed) on " << workers << " workers: "
+              << total_cycles << " cycles in " << elapsed_seconds << " s = "
+              << aggregate_mhz << " MHz aggregate\n";
+
+    return failed ? 2 : 0;
+}
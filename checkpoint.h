@@ -0,0 +1,156 @@
+// FAST Hybrid CPU - checkpoint/restore
+// Snapshots the whole model (register files, caches, PC/RIP, mode) through
+// Verilator's --savable VerilatedSave/VerilatedRestore streams, together with
+// the harness cycle counter so long runs can fast-forward to cycle N. The
+// sparse guest memory lives outside the model, so its allocated pages go
+// ahead of the model stream as { page size, page count, then address + bytes
+// per page }, and the magic is repeated at the end so a truncated file is
+// rejected before anything is restored.
+
+#pragma once
+
+#include "hybrid_model.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#ifdef HYBRID_SAVABLE
+#include "verilated_save.h"
+#endif
+
+// Header written ahead of the model stream; bump the version whenever the
+// RTL state layout changes so stale snapshots are rejected
+static const uint64_t CHECKPOINT_MAGIC = 0x54504B4352425948ULL; // "HYBRCKPT"
+static const uint64_t CHECKPOINT_VERSION = 12; // v12: guest pages ahead of the model stream
+
+// VerilatedSave frames every file with this header and trailer; check_checkpoint
+// reads the raw file around them
+static const char VERILATED_SAVE_HEADER[] = "verilatorsave01\n";
+static const char VERILATED_SAVE_TRAILER[] = "vltsaved";
+
+inline bool save_checkpoint(VRV64GC_optimized* cpu, const char* path, uint64_t cycle, std::string& error) {
+#ifdef HYBRID_SAVABLE
+    GuestMemory* memory = attached_memory(cpu);
+    if (!memory) {
+        error = "no guest memory attached to the model";
+        return false;
+    }
+    VerilatedSave os;
+    os.open(path);
+    if (!os.isOpen()) {
+        error = std::string("cannot create checkpoint ") + path;
+        return false;
+    }
+    uint64_t magic = CHECKPOINT_MAGIC;
+    uint64_t version = CHECKPOINT_VERSION;
+    uint64_t page_bytes = memory->page_bytes();
+    uint64_t pages = memory->page_count();
+    os << magic << version << cycle << page_bytes << pages;
+    memory->for_each_page([&os, page_bytes](uint64_t addr, const uint8_t* data) {
+        os << addr;
+        os.write(data, page_bytes);
+    });
+    os << *cpu;
+    os << magic;
+    os.close();
+    return true;
+#else
+    (void)cpu; (void)path; (void)cycle;
+    error = "model was built without --savable (SAVABLE=0)";
+    return false;
+#endif
+}
+
+// Validate a checkpoint file without touching any state: header, page size,
+// a page table the file can hold, and the end marker (a short file would
+// otherwise read as zeros, and VerilatedRestore aborts on a bad trailer)
+inline bool check_checkpoint(const char* path, uint64_t page_bytes, std::string& error) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        error = std::string("cannot open checkpoint ") + path;
+        return false;
+    }
+    const uint64_t header_bytes = sizeof(VERILATED_SAVE_HEADER) - 1;
+    const uint64_t trailer_bytes = sizeof(VERILATED_SAVE_TRAILER) - 1;
+    char header[sizeof(VERILATED_SAVE_HEADER) - 1];
+    uint64_t fields[5]; // magic, version, cycle, page bytes, page count
+    struct stat file_stat;
+    bool readable = fstat(fileno(file), &file_stat) == 0 && fread(header, header_bytes, 1, file) == 1 &&
+                    fread(fields, sizeof(fields), 1, file) == 1;
+    uint64_t size = readable ? static_cast<uint64_t>(file_stat.st_size) : 0;
+    uint64_t table = header_bytes + sizeof(fields);              // First page record
+    uint64_t footer = sizeof(uint64_t) + trailer_bytes;          // End magic + trailer
+
+    const char* problem = nullptr;
+    if (!readable || memcmp(header, VERILATED_SAVE_HEADER, header_bytes) != 0 ||
+        fields[0] != CHECKPOINT_MAGIC || fields[1] != CHECKPOINT_VERSION) {
+        problem = "not a compatible hybridcpu64 checkpoint: ";
+    } else if (fields[3] != page_bytes) {
+        problem = "checkpoint page size differs from this guest memory (--huge-pages?): ";
+    } else if (size < table + footer || fields[4] > (size - table - footer) / (sizeof(uint64_t) + page_bytes)) {
+        problem = "corrupt checkpoint page table: ";
+    } else {
+        uint64_t end_magic = 0;
+        char trailer[sizeof(VERILATED_SAVE_TRAILER) - 1];
+        if (fseek(file, static_cast<long>(size - footer), SEEK_SET) != 0 ||
+            fread(&end_magic, sizeof(end_magic), 1, file) != 1 || fread(trailer, trailer_bytes, 1, file) != 1 ||
+            end_magic != CHECKPOINT_MAGIC || memcmp(trailer, VERILATED_SAVE_TRAILER, trailer_bytes) != 0) {
+            problem = "truncated checkpoint: ";
+        }
+    }
+    fclose(file);
+    if (problem) {
+        error = std::string(problem) + path;
+        return false;
+    }
+    return true;
+}
+
+// Restore into an already constructed model with memory attached; cycle
+// receives the saved counter. The file is checked first, so on failure the
+// model and guest memory are untouched
+inline bool restore_checkpoint(VRV64GC_optimized* cpu, const char* path, uint64_t& cycle, std::string& error) {
+#ifdef HYBRID_SAVABLE
+    GuestMemory* memory = attached_memory(cpu);
+    if (!memory) {
+        error = "no guest memory attached to the model";
+        return false;
+    }
+    if (!check_checkpoint(path, memory->page_bytes(), error)) return false;
+    VerilatedRestore os;
+    os.open(path);
+    if (!os.isOpen()) {
+        error = std::string("cannot open checkpoint ") + path;
+        return false;
+    }
+    uint64_t magic = 0, version = 0, page_bytes = 0, pages = 0;
+    os >> magic >> version >> cycle >> page_bytes >> pages;
+
+    // Run initial blocks first so they cannot clobber the restored state
+    cpu->eval();
+    std::vector<uint8_t> page(page_bytes);
+    memory->clear();
+    for (uint64_t i = 0; i < pages; i++) {
+        uint64_t addr = 0;
+        os >> addr;
+        os.read(page.data(), page_bytes);
+        memory->write_bytes(addr, page.data(), page_bytes);
+    }
+    GuestConsole* console = attached_console(cpu);
+    os >> *cpu;
+    // The saved handles belonged to the saving process
+    rtl_mem_handle(cpu) = reinterpret_cast<uintptr_t>(memory);
+    rtl_console_handle(cpu) = reinterpret_cast<uintptr_t>(console);
+    uint64_t end_magic = 0;
+    os >> end_magic;
+    os.close();
+    return true;
+#else
+    (void)cpu; (void)path; (void)cycle;
+    error = "model was built without --savable (SAVABLE=0)";
+    return false;
+#endif
+}
@@ -1,71 +1,735 @@
-#include "VRV64GC_optimized.h"
-#include "verilated.h"
-#include <iostream>
+// FAST Hybrid CPU - simulation speed benchmark suite
+// Runs named workloads with warmup and repeated trials, reports median/p99
+// simulated cycles per second and optionally writes the results as JSON.
+//
+// Usage: clock_benchmark [--cycles N] [--trials N] [--warmup N]
+//                        [--workload name]... [--label text] [--json path]
+//                        [--profile-every N] [--time-warp]
+//        clock_benchmark --check-warp [--cycles N] [--workload name]...
+//
+// --profile-every runs every trial under the PC sampling profiler, so its
+// overhead is the MHz difference against a run without it. --time-warp runs
+// every trial through TimeWarp (time_warp.h), which skips idle and NOP-sled
+// stretches with the same counters; compare the idle_sled workloads with and
+// without it. --check-warp benchmarks nothing: it runs each workload ticked and
+// warped and fails unless both end in the same state, counters and cache
+// internals (make time_warp_check runs it per replacement policy). Guest console output goes to /dev/null through the usual
+// batched GuestConsole path.
+
+#include "hybrid_model.h"
+#include "pc_profiler.h"
+#include "program_loader.h"
+#include "time_warp.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+// === INSTRUCTION ENCODERS (only what the RTL decodes) ===
+static uint32_t rv_itype(int32_t imm, unsigned rs1, unsigned funct3, unsigned rd) {
+    return (static_cast<uint32_t>(imm & 0xFFF) << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | 0x13;
+}
+
+static uint32_t rv_rtype(unsigned funct7, unsigned rs2, unsigned rs1, unsigned funct3, unsigned rd) {
+    return (funct7 << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | (rd << 7) | 0x33;
+}
+
+static uint32_t rv_lui(uint32_t imm20, unsigned rd) {
+    return (imm20 << 12) | (rd << 7) | 0x37;
+}
+
+static uint32_t rv_load(int32_t imm, unsigned rs1, unsigned funct3, unsigned rd) {
+    return (rv_itype(imm, rs1, funct3, rd) & ~0x7Fu) | 0x03;
+}
+
+static uint32_t rv_store(int32_t imm, unsigned rs2, unsigned rs1, unsigned funct3) {
+    uint32_t u = static_cast<uint32_t>(imm);
+    return ((u >> 5 & 0x7F) << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) | ((u & 0x1F) << 7) | 0x23;
+}
+
+// RISC-V V subset: vsetvli, unmasked OP-V arithmetic, unit-stride vle/vse
+static uint32_t rv_vsetvli(unsigned vtypei, unsigned rs1, unsigned rd) {
+    return (vtypei << 20) | (rs1 << 15) | (0x7 << 12) | (rd << 7) | 0x57;
+}
+
+static uint32_t rv_varith(unsigned funct6, unsigned vs2, unsigned vs1, unsigned funct3, unsigned vd) {
+    return (funct6 << 26) | (1u << 25) | (vs2 << 20) | (vs1 << 15) | (funct3 << 12) | (vd << 7) | 0x57;
+}
+
+static uint32_t rv_vmem(unsigned opcode, unsigned width, unsigned rs1, unsigned vd) {
+    return (1u << 25) | (rs1 << 15) | (width << 12) | (vd << 7) | opcode;
+}
+
+static const unsigned RV_VTYPE_E32 = 0x10;   // SEW = 32, LMUL = 1
+static const unsigned RV_VWIDTH_32 = 0x6;
+
+// Branch/jump offsets are in bytes relative to the instruction
+static uint32_t rv_branch(int32_t offset, unsigned rs2, unsigned rs1, unsigned funct3) {
+    uint32_t u = static_cast<uint32_t>(offset);
+    return ((u >> 12 & 0x1) << 31) | ((u >> 5 & 0x3F) << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) |
+           ((u >> 1 & 0xF) << 8) | ((u >> 11 & 0x1) << 7) | 0x63;
+}
+
+static uint32_t rv_jal(int32_t offset, unsigned rd) {
+    uint32_t u = static_cast<uint32_t>(offset);
+    return ((u >> 20 & 0x1) << 31) | ((u >> 1 & 0x3FF) << 21) | ((u >> 11 & 0x1) << 20) | ((u >> 12 & 0xFF) << 12) |
+           (rd << 7) | 0x6F;
+}
+
+// REX.W C7 /r with an 8-bit immediate in the last byte, as decoded by fast_x86_alu
+static uint32_t x86_mov_imm(unsigned reg, uint8_t imm) {
+    return (static_cast<uint32_t>(imm) << 24) | ((0xC0 | reg) << 16) | (0xC7 << 8) | 0x48;
+}
+
+static const uint32_t X86_ADD_RAX_RCX = 0x00C80148; // REX.W 01 C8
+static const uint32_t X86_MOVDQU_XMM0_RCX = 0x016F0FF3; // F3 0F 6F 01   MOVDQU xmm0,[rcx]
+static const uint32_t X86_MOVDQU_XMM1_RAX = 0x086F0FF3; // F3 0F 6F 08   MOVDQU xmm1,[rax]
+static const uint32_t X86_PADDQ_XMM0_XMM1 = 0xC1D40F66; // 66 0F D4 C1   PADDQ xmm0,xmm1
+static const uint32_t X86_PMULLD = 0x40380F66;          // 66 0F 38 40 ...
+static const uint32_t X86_PMULLD_MODRM_XMM0_XMM1 = 0x909090C1; // ... C1, NOP padding
+static const uint32_t X86_MOVDQU_RCX_XMM0 = 0x017F0FF3; // F3 0F 7F 01   MOVDQU [rcx],xmm0
+static const uint32_t MODE_SWITCH = 0xDEADBEEF;
+static const uint32_t RV_NOP = 0x00000013;      // ADDI x0,x0,0
+static const uint32_t RV_WFI = 0x10500073;
+static const uint32_t X86_NOPS = 0x90909090;    // Four one-byte NOPs
+static const uint32_t X86_HLT = 0x000000F4;     // HLT (parks before the rest of the word)
+static const uint64_t X86_BOOT_RIP = 0x400000; // boot_rip after power-on
+
+// === WORKLOADS ===
+struct Workload {
+    const char* name;
+    const char* description;
+    std::vector<uint32_t> program;     // Loaded at address 0 (the boot PC)
+    uint64_t reset_period;             // Re-enter RISC-V mode every N cycles (0 = never)
+    bool concurrent = false;           // Both cores run every cycle
+    std::vector<uint32_t> x86_program = {}; // Loaded at the boot RIP, for concurrent runs
+};
+
+static void fill_riscv_alu(std::vector<uint32_t>& program, size_t begin, size_t end) {
+    const uint32_t block[] = {
+        rv_itype(1, 1, 0, 1),         // ADDI x1,x1,1
+        rv_itype(3, 2, 0, 2),         // ADDI x2,x2,3
+        rv_rtype(0x00, 2, 1, 0, 3),   // ADD  x3,x1,x2
+        rv_rtype(0x00, 2, 1, 4, 4),   // XOR  x4,x1,x2
+        rv_rtype(0x01, 2, 1, 0, 5),   // MUL  x5,x1,x2
+        rv_itype(0x55, 3, 4, 6),      // XORI x6,x3,0x55
+    };
+    for (size_t i = begin; i < end; i++) program[i] = block[(i - begin) % 6];
+}
+
+// Counted loop over a memory cell with a data-dependent branch that alternates
+// every iteration: static/bimodal predictors miss it half the time, gshare learns it
+static void fill_riscv_loop(std::vector<uint32_t>& program) {
+    const uint32_t loop[] = {
+        rv_itype(0, 0, 0, 1),         //  0: ADDI x1,x0,0       i = 0
+        rv_itype(64, 0, 0, 2),        //  1: ADDI x2,x0,64      n = 64
+        rv_itype(0x100, 0, 0, 6),     //  2: ADDI x6,x0,0x100   &cell
+        rv_rtype(0x00, 1, 3, 0, 3),   //  3: ADD  x3,x3,x1      loop: sum += i
+        rv_store(0, 3, 6, 3),         //  4: SD   x3,0(x6)
+        rv_load(0, 6, 3, 7),          //  5: LD   x7,0(x6)
+        rv_itype(1, 1, 0, 1),         //  6: ADDI x1,x1,1
+        rv_itype(1, 1, 7, 9),         //  7: ANDI x9,x1,1
+        rv_branch(8, 0, 9, 0),        //  8: BEQ  x9,x0,+8      skip on even i
+        rv_rtype(0x00, 1, 7, 4, 8),   //  9: XOR  x8,x7,x1
+        rv_branch(-28, 2, 1, 1),      // 10: BNE  x1,x2,loop
+        rv_jal(-44, 0),               // 11: JAL  x0,0          start over
+    };
+    std::copy(std::begin(loop), std::end(loop), program.begin());
+}
+
+// printf-style guest: one SB to the console UART per character, forever
+// (or once, falling through to whatever follows)
+static void fill_riscv_print(std::vector<uint32_t>& program,
+                             const char* message = "Hello from the hybrid CPU console!\n", bool loop = true) {
+    program.clear();
+    program.push_back(rv_lui(static_cast<uint32_t>(CONSOLE_BASE >> 12), 5)); // LUI x5,CONSOLE_BASE
+    for (const char* c = message; *c; c++) {
+        program.push_back(rv_itype(*c, 0, 0, 6));  // ADDI x6,x0,c
+        program.push_back(rv_store(0, 6, 5, 0));   // SB   x6,0(x5)
+    }
+    if (!loop) return;
+    int32_t body = static_cast<int32_t>(program.size() - 1) * 4;
+    program.push_back(rv_jal(-body, 0));           // JAL  x0,loop (after the LUI)
+}
+
+// Strip-mined c[i] = (a[i] + b[i]) * a[i] over 10 words: vl goes 4, 4, 2, so
+// the last strip leaves two of the four 32-bit lanes idle
+static void fill_riscv_vector(std::vector<uint32_t>& program) {
+    const uint32_t kernel[] = {
+        rv_itype(0x400, 0, 0, 10),            //  0: ADDI x10,x0,0x400   a
+        rv_itype(0x500, 0, 0, 11),            //  1: ADDI x11,x0,0x500   b
+        rv_itype(0x600, 0, 0, 12),            //  2: ADDI x12,x0,0x600   c
+        rv_itype(10, 0, 0, 13),               //  3: ADDI x13,x0,10      n
+        rv_vsetvli(RV_VTYPE_E32, 13, 15),     //  4: VSETVLI x15,x13,e32,m1   strip: vl = min(n, 4)
+        rv_vmem(0x07, RV_VWIDTH_32, 10, 1),   //  5: VLE32.V v1,(x10)
+        rv_vmem(0x07, RV_VWIDTH_32, 11, 2),   //  6: VLE32.V v2,(x11)
+        rv_varith(0x00, 2, 1, 0, 3),          //  7: VADD.VV v3,v2,v1
+        rv_varith(0x25, 3, 1, 2, 4),          //  8: VMUL.VV v4,v3,v1
+        rv_vmem(0x27, RV_VWIDTH_32, 12, 4),   //  9: VSE32.V v4,(x12)
+        rv_itype(2, 15, 1, 16),               // 10: SLLI x16,x15,2
+        rv_rtype(0x00, 16, 10, 0, 10),        // 11: ADD  x10,x10,x16
+        rv_rtype(0x00, 16, 11, 0, 11),        // 12: ADD  x11,x11,x16
+        rv_rtype(0x00, 16, 12, 0, 12),        // 13: ADD  x12,x12,x16
+        rv_rtype(0x20, 15, 13, 0, 13),        // 14: SUB  x13,x13,x15
+        rv_branch(-44, 0, 13, 1),             // 15: BNE  x13,x0,strip
+        rv_jal(-64, 0),                       // 16: JAL  x0,0           start over
+    };
+    program.assign(std::begin(kernel), std::end(kernel));
+}
+
+// Load two xmm registers, PADDQ + PMULLD them, store the result
+static void fill_x86_sse(std::vector<uint32_t>& program, size_t begin, size_t end) {
+    const uint32_t block[] = {
+        x86_mov_imm(1, 0x10), X86_MOVDQU_XMM0_RCX, x86_mov_imm(0, 0x20), X86_MOVDQU_XMM1_RAX,
+        X86_PADDQ_XMM0_XMM1, X86_PMULLD, X86_PMULLD_MODRM_XMM0_XMM1, X86_MOVDQU_RCX_XMM0,
+    };
+    for (size_t i = begin; i < end; i++) program[i] = block[(i - begin) % 8];
+}
+
+static void fill_x86_alu(std::vector<uint32_t>& program, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        switch ((i - begin) % 3) {
+            case 0: program[i] = x86_mov_imm(0, static_cast<uint8_t>(i)); break;
+            case 1: program[i] = x86_mov_imm(1, static_cast<uint8_t>(i * 3)); break;
+            default: program[i] = X86_ADD_RAX_RCX; break;
+        }
+    }
+}
+
+// A little work, a long run of NOPs, then park until the next reset: the
+// shape of a guest that boots and idles, and what --time-warp skips
+static void fill_idle_sled(std::vector<uint32_t>& program, uint32_t sled_word, uint32_t park_word, size_t begin) {
+    size_t end = program.size() - 1;
+    for (size_t i = begin; i < end; i++) program[i] = sled_word;
+    program[end] = park_word;
+}
+
+static std::vector<Workload> make_workloads() {
+    std::vector<Workload> workloads;
+
+    Workload alu = {"riscv_alu", "RISC-V ADDI/ADD/XOR/MUL/XORI stream, 127 ops + JAL back", std::vector<uint32_t>(128), 0};
+    fill_riscv_alu(alu.program, 0, 127);
+    alu.program[127] = rv_jal(-127 * 4, 0);
+    workloads.push_back(alu);
+
+    Workload loop = {"riscv_loop", "RISC-V counted loop: LD/SD, alternating branch, back-edge, JAL", std::vector<uint32_t>(128), 0};
+    fill_riscv_loop(loop.program);
+    workloads.push_back(loop);
+
+    Workload print = {"console_print", "RISC-V printf loop: LUI + ADDI/SB per char to the UART", {}, 0};
+    fill_riscv_print(print.program);
+    workloads.push_back(print);
+
+    Workload vector = {"riscv_vector", "RISC-V V strip-mined loop: VSETVLI, VLE32 x2, VADD, VMUL, VSE32", {}, 0};
+    fill_riscv_vector(vector.program);
+    workloads.push_back(vector);
+
+    // The x86 core has no branches, so reset restarts the stream every pass
+    Workload x86 = {"x86_alu", "0xDEADBEEF switch, then REX.W MOV/ADD stream, reset, repeat", std::vector<uint32_t>(128), 128};
+    x86.program[0] = MODE_SWITCH;
+    fill_x86_alu(x86.program, 1, 128);
+    workloads.push_back(x86);
+
+    Workload sse = {"x86_sse", "0xDEADBEEF switch, then MOVDQU/PADDQ/PMULLD blocks, reset, repeat", std::vector<uint32_t>(128), 128};
+    sse.program[0] = MODE_SWITCH;
+    fill_x86_sse(sse.program, 1, 121);
+    workloads.push_back(sse);
+
+    // The RTL has no x86 -> RISC-V switch, so reset brings the core back every pass
+    Workload mixed = {"mixed_switch", "64 RISC-V ops, switch, 63 x86 ops, reset, repeat", std::vector<uint32_t>(128), 128};
+    fill_riscv_alu(mixed.program, 0, 64);
+    mixed.program[64] = MODE_SWITCH;
+    fill_x86_alu(mixed.program, 65, 128);
+    workloads.push_back(mixed);
+
+    // Both cores from reset: RISC-V loops at 0, x86 runs its stream at the boot
+    // RIP until the next reset, so this measures aggregate throughput
+    Workload dual = {"dual_concurrent", "Concurrent cores: RISC-V loop + 96 x86 ops, reset, repeat", std::vector<uint32_t>(64), 128};
+    fill_riscv_alu(dual.program, 0, 63);
+    dual.program[63] = rv_jal(-63 * 4, 0);
+    dual.concurrent = true;
+    dual.x86_program.resize(96);
+    fill_x86_alu(dual.x86_program, 0, 96);
+    workloads.push_back(dual);
+
+    // 16 ops and WFI: all but a few dozen cycles of each pass are idle
+    Workload wfi = {"idle_wfi", "RISC-V: 16 ALU ops, WFI, reset every 64K cycles", std::vector<uint32_t>(17), 65536};
+    fill_riscv_alu(wfi.program, 0, 16);
+    wfi.program[16] = RV_WFI;
+    workloads.push_back(wfi);
+
+    // 16 ops, a 16 KiB sled, WFI; the rest of each 64K-cycle pass is idle
+    Workload rv_idle = {"idle_sled", "RISC-V: 16 ALU ops, 4096-NOP sled, WFI, reset every 64K cycles", std::vector<uint32_t>(4113), 65536};
+    fill_riscv_alu(rv_idle.program, 0, 16);
+    fill_idle_sled(rv_idle.program, RV_NOP, RV_WFI, 16);
+    workloads.push_back(rv_idle);
+
+    // The same sled entered with "idle\n" still queued in the UART: with a slow
+    // UART (make time_warp_check) the bytes drain while the sled runs
+    Workload print_idle = {"print_idle_sled", "RISC-V: 5 console bytes, 4096-NOP sled, WFI, reset every 64K cycles", {}, 65536};
+    fill_riscv_print(print_idle.program, "idle\n", false);
+    print_idle.program.resize(print_idle.program.size() + 4097);
+    fill_idle_sled(print_idle.program, RV_NOP, RV_WFI, print_idle.program.size() - 4097);
+    workloads.push_back(print_idle);
+
+    Workload x86_idle = {"x86_idle_sled", "0xDEADBEEF switch, 16 KiB of x86 NOPs, HLT, reset every 64K cycles", std::vector<uint32_t>(4098), 65536};
+    x86_idle.program[0] = MODE_SWITCH;
+    fill_idle_sled(x86_idle.program, X86_NOPS, X86_HLT, 1);
+    workloads.push_back(x86_idle);
+
+    return workloads;
+}
+
+static void load_workload(VRV64GC_optimized* cpu, GuestMemory& memory, const Workload& workload) {
+    set_concurrent(cpu, workload.concurrent); // Also runs the initial blocks first
+    memory.clear();
+    write_guest_words(memory, 0, workload.program.data(), workload.program.size());
+    write_guest_words(memory, X86_BOOT_RIP, workload.x86_program.data(), workload.x86_program.size());
+    reset_cpu(cpu);
+}
+
+static void run_span(VRV64GC_optimized* cpu, PcProfiler* profiler, TimeWarp* warp, uint64_t cycles) {
+    if (profiler && warp) profiler->run(cpu, cycles, [warp](uint64_t n) { warp->run(n); });
+    else if (profiler) profiler->run(cpu, cycles);
+    else if (warp) warp->run(cycles);
+    else run_cycles(cpu, cycles);
+}
+
+static void run_workload(VRV64GC_optimized* cpu, const Workload& workload, uint64_t cycles,
+                         PcProfiler* profiler = nullptr, TimeWarp* warp = nullptr) {
+    if (warp) warp->reset();
+    if (!workload.reset_period) {
+        run_span(cpu, profiler, warp, cycles);
+        return;
+    }
+    for (uint64_t done = 0; done < cycles; done += workload.reset_period) {
+        cpu->rst = 1;
+        tick(cpu);
+        cpu->rst = 0;
+        if (warp) warp->reset();
+        run_span(cpu, profiler, warp, std::min(workload.reset_period, cycles - done) - 1);
+    }
+}
+
+// === MEASUREMENT ===
+struct WorkloadResult {
+    std::string name;
+    double median_cps;
+    double p99_cps;   // Rate of the 99th-percentile (slow tail) trial
+    double best_cps;
+    uint64_t final_pc;
+    uint64_t final_rip;
+    bool final_x86_mode;
+    unsigned bp_scheme;
+    uint64_t console_bytes;   // Guest console output of the last trial
+    uint64_t console_flushes; // ... and the host writes it took
+    uint64_t warped_cycles;   // Cycles the time warp skipped in the last trial
+    uint64_t warps;
+    PerfCounters perf; // Hardware counters of the last trial
+};
+
+static double percentile(std::vector<double> values, double p) {
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[rank ? rank - 1 : 0];
+}
+
+static WorkloadResult benchmark_workload(const Workload& workload, uint64_t cycles, int warmup, int trials,
+                                         uint64_t profile_every, bool time_warp) {
+    std::unique_ptr<VerilatedContext> context(new VerilatedContext);
+    int null_fd = open("/dev/null", O_WRONLY);
+    GuestMemory memory;
+    std::unique_ptr<GuestConsole> console;
+    std::unique_ptr<VRV64GC_optimized> cpu(new VRV64GC_optimized(context.get()));
+    attach_memory(cpu.get(), &memory);
+    std::unique_ptr<PcProfiler> profiler;
+    if (profile_every) profiler.reset(new PcProfiler(profile_every));
+    std::unique_ptr<TimeWarp> warp;
+
+    std::vector<double> trial_seconds;
+    for (int trial = 0; trial < warmup + trials; trial++) {
+        load_workload(cpu.get(), memory, workload);
+        console.reset(new GuestConsole(null_fd));
+        attach_console(cpu.get(), console.get());
+        if (profiler) profiler->clear();
+        if (time_warp) warp.reset(new TimeWarp(cpu.get()));
+
+        auto start_time = std::chrono::steady_clock::now();
+        run_workload(cpu.get(), workload, cycles, profiler.get(), warp.get());
+        console->flush(); // Part of the cost of printing
+        auto end_time = std::chrono::steady_clock::now();
+
+        if (trial >= warmup) {
+            trial_seconds.push_back(std::chrono::duration<double>(end_time - start_time).count());
+        }
+    }
+
+    WorkloadResult result;
+    result.name = workload.name;
+    result.median_cps = cycles / percentile(trial_seconds, 0.50);
+    result.p99_cps = cycles / percentile(trial_seconds, 0.99);
+    result.best_cps = cycles / *std::min_element(trial_seconds.begin(), trial_seconds.end());
+
+    CpuState state = capture_state(cpu.get());
+    result.final_pc = state.pc;
+    result.final_rip = state.x86_rip;
+    result.final_x86_mode = state.x86_mode;
+    result.bp_scheme = cpu->rv_bp_scheme;
+    result.perf = capture_counters(cpu.get());
+    result.console_bytes = console->bytes();
+    result.console_flushes = console->flushes();
+    result.warped_cycles = warp ? warp->warped_cycles() : 0;
+    result.warps = warp ? warp->warps() : 0;
+    cpu->final();
+    if (null_fd >= 0) close(null_fd);
+    return result;
+}
+
+static bool write_json(const char* path, const std::string& label, uint64_t cycles, int warmup, int trials,
+                       uint64_t profile_every, bool time_warp, const std::vector<WorkloadResult>& results) {
+    FILE* out = fopen(path, "w");
+    if (!out) return false;
+
+    fprintf(out, "{\n  \"label\": \"%s\",\n", label.c_str());
+    fprintf(out, "  \"cycles_per_trial\": %llu,\n  \"warmup\": %d,\n  \"trials\": %d,\n  \"profile_every\": %llu,\n",
+            static_cast<unsigned long long>(cycles), warmup, trials, static_cast<unsigned long long>(profile_every));
+    fprintf(out, "  \"time_warp\": %d,\n", time_warp ? 1 : 0);
+    fprintf(out, "  \"workloads\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const WorkloadResult& r = results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"median_cps\": %.0f, \"p99_cps\": %.0f, \"best_cps\": %.0f, "
+                     "\"median_mhz\": %.3f, \"median_mips\": %.3f, \"final_pc\": \"0x%llx\", \"final_rip\": \"0x%llx\", \"x86_mode\": %d,\n",
+                r.name.c_str(), r.median_cps, r.p99_cps, r.best_cps, r.median_cps / 1e6,
+                r.median_cps * ratio(r.perf.minstret, r.perf.mcycle) / 1e6,
+                static_cast<unsigned long long>(r.final_pc), static_cast<unsigned long long>(r.final_rip),
+                r.final_x86_mode ? 1 : 0);
+
+        const PerfCounters& p = r.perf;
+        fprintf(out, "     \"counters\": {\"mcycle\": %llu, \"minstret\": %llu, \"ipc\": %.4f, "
+                     "\"rv_mcycle\": %llu, \"rv_minstret\": %llu, \"x86_mcycle\": %llu, \"x86_minstret\": %llu, "
+                     "\"mode_switches\": %llu, \"unknown_skips\": %llu, \"bp\": \"%s\", "
+                     "\"rv_stall_cycles\": %llu, \"rv_flushes\": %llu, \"rv_branches\": %llu, \"rv_mispredicts\": %llu",
+                static_cast<unsigned long long>(p.mcycle), static_cast<unsigned long long>(p.minstret),
+                ratio(p.minstret, p.mcycle),
+                static_cast<unsigned long long>(p.rv_mcycle), static_cast<unsigned long long>(p.rv_minstret),
+                static_cast<unsigned long long>(p.x86_mcycle), static_cast<unsigned long long>(p.x86_minstret),
+                static_cast<unsigned long long>(p.mode_switches), static_cast<unsigned long long>(p.unknown_skips),
+                bp_scheme_name(r.bp_scheme),
+                static_cast<unsigned long long>(p.rv_stall_cycles), static_cast<unsigned long long>(p.rv_flushes),
+                static_cast<unsigned long long>(p.rv_branches), static_cast<unsigned long long>(p.rv_mispredicts));
+        fprintf(out, ", \"l1i_hits\": %llu, \"l1i_misses\": %llu, \"l1i_evictions\": %llu, "
+                     "\"l1d_hits\": %llu, \"l1d_misses\": %llu, \"l1d_evictions\": %llu",
+                static_cast<unsigned long long>(p.l1i_hits), static_cast<unsigned long long>(p.l1i_misses),
+                static_cast<unsigned long long>(p.l1i_evictions), static_cast<unsigned long long>(p.l1d_hits),
+                static_cast<unsigned long long>(p.l1d_misses), static_cast<unsigned long long>(p.l1d_evictions));
+        for (int c = 0; c < PERF_CLASS_COUNT; c++) {
+            if (perf_class_name(c)) {
+                fprintf(out, ", \"%s\": %llu", perf_class_name(c), static_cast<unsigned long long>(p.class_retired[c]));
+            }
+        }
+        fprintf(out, ", \"console_bytes\": %llu, \"console_flushes\": %llu, \"console_overruns\": %llu",
+                static_cast<unsigned long long>(r.console_bytes), static_cast<unsigned long long>(r.console_flushes),
+                static_cast<unsigned long long>(p.console_overruns));
+        fprintf(out, ", \"rv_simd_ops\": %llu, \"rv_simd_elements\": %llu, \"x86_simd_ops\": %llu, "
+                     "\"x86_simd_elements\": %llu, \"simd_lane_active\": [",
+                static_cast<unsigned long long>(p.rv_simd_ops), static_cast<unsigned long long>(p.rv_simd_elements),
+                static_cast<unsigned long long>(p.x86_simd_ops), static_cast<unsigned long long>(p.x86_simd_elements));
+        for (int lane = 0; lane < VEC_LANES; lane++) {
+            fprintf(out, "%s%llu", lane ? ", " : "", static_cast<unsigned long long>(p.simd_lane_active[lane]));
+        }
+        fprintf(out, "]");
+        fprintf(out, ", \"rv_idle_cycles\": %llu, \"x86_idle_cycles\": %llu",
+                static_cast<unsigned long long>(p.rv_idle_cycles), static_cast<unsigned long long>(p.x86_idle_cycles));
+        fprintf(out, "}, \"warped_cycles\": %llu, \"warps\": %llu}%s\n",
+                static_cast<unsigned long long>(r.warped_cycles), static_cast<unsigned long long>(r.warps),
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+    return true;
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--cycles N] [--trials N] [--warmup N]"
+              << " [--workload name]... [--label text] [--json path] [--profile-every N] [--time-warp]\n"
+              << "       " << argv0 << " --check-warp [--cycles N] [--workload name]...\n";
+}
+
+// === TIME WARP CHECK ===
+// Everything a warp may touch, by name: architectural state, every counter,
+// the console output and the RTL internals TimeWarp rewrites
+typedef std::vector<std::pair<std::string, uint64_t>> WarpFingerprint;
+
+static WarpFingerprint warp_fingerprint(VRV64GC_optimized* cpu, const GuestConsole& console) {
+    static_assert(sizeof(PerfCounters) % sizeof(uint64_t) == 0, "PerfCounters is all 64-bit counters");
+    WarpFingerprint f;
+    auto add = [&f](const std::string& name, uint64_t value) { f.emplace_back(name, value); };
+    CpuState s = capture_state(cpu);
+    add("pc", s.pc);
+    add("x86_rip", s.x86_rip);
+    add("x86_mode", s.x86_mode);
+    add("rv_active", s.rv_active);
+    add("rv_idle", s.rv_idle);
+    add("x86_idle", s.x86_idle);
+    for (int i = 0; i < 32; i++) add("x" + std::to_string(i), s.regs[i]);
+    for (int i = 0; i < 16; i++) add("x86_r" + std::to_string(i), s.x86_regs[i]);
+    for (int i = 0; i < 32; i++) {
+        add("v" + std::to_string(i) + ".lo", s.vregs[i][0]);
+        add("v" + std::to_string(i) + ".hi", s.vregs[i][1]);
+    }
+    add("vl", s.vl);
+    add("vsew", s.vsew);
+    for (int i = 0; i < X86_XMM_REGS; i++) {
+        add("xmm" + std::to_string(i) + ".lo", s.xmm[i][0]);
+        add("xmm" + std::to_string(i) + ".hi", s.xmm[i][1]);
+    }
+
+    PerfCounters perf = capture_counters(cpu);
+    uint64_t words[sizeof(PerfCounters) / sizeof(uint64_t)];
+    memcpy(words, &perf, sizeof(perf));
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) add("PerfCounters word " + std::to_string(i), words[i]);
+    add("console bytes", console.bytes());
+
+    auto* root = cpu->rootp;
+    add("rv fetch_pc", rtl_rv_fetch_pc(cpu));
+    add("rv retire_pc", root->RV64GC_optimized__DOT__rv_core__DOT__retire_pc);
+    add("x86 retire_pc", root->RV64GC_optimized__DOT__x86_core__DOT__retire_pc);
+    for (uint32_t i = 0; i < cpu->l1i_lines; i++) {
+        add("l1i valid" + std::to_string(i), rtl_l1i_valid(cpu)[i]);
+        add("l1i tag" + std::to_string(i), rtl_l1i_tags(cpu)[i]);
+    }
+    add("l1i fill_busy", rtl_l1i_fill_busy(cpu));
+    add("l1i fill_line", rtl_l1i_fill_line(cpu));
+    add("l1i waited_line0", root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__waited_line0);
+    add("l1i waited_line1", root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__waited_line1);
+    add("l1i lfsr", rtl_l1i_lfsr(cpu));
+    add("l1d lfsr", rtl_l1d_lfsr(cpu));
+    add("uart count", root->RV64GC_optimized__DOT__mem__DOT__uart__DOT__count);
+    add("uart tx_timer", root->RV64GC_optimized__DOT__mem__DOT__uart__DOT__tx_timer);
+    return f;
+}
+
+// Run the workload ticked and warped on two models; true when both end in
+// the same fingerprint and the warp actually skipped something
+static bool check_time_warp(const Workload& workload, uint64_t cycles) {
+    std::unique_ptr<VerilatedContext> context(new VerilatedContext);
+    int null_fd = open("/dev/null", O_WRONLY);
+    WarpFingerprint ends[2];
+    uint64_t warped = 0, warps = 0;
+    for (int warp_on = 0; warp_on < 2; warp_on++) {
+        GuestMemory memory;
+        GuestConsole console(null_fd);
+        std::unique_ptr<VRV64GC_optimized> cpu(new VRV64GC_optimized(context.get()));
+        attach_memory(cpu.get(), &memory);
+        attach_console(cpu.get(), &console);
+        load_workload(cpu.get(), memory, workload);
+        std::unique_ptr<TimeWarp> warp;
+        if (warp_on) warp.reset(new TimeWarp(cpu.get()));
+        run_workload(cpu.get(), workload, cycles, nullptr, warp.get());
+        console.flush();
+        ends[warp_on] = warp_fingerprint(cpu.get(), console);
+        if (warp) {
+            warped = warp->warped_cycles();
+            warps = warp->warps();
+        }
+        cpu->final();
+    }
+    if (null_fd >= 0) close(null_fd);
+
+    int diffs = 0;
+    for (size_t i = 0; i < ends[0].size(); i++) {
+        if (ends[0][i].second == ends[1][i].second) continue;
+        if (diffs++ < 8) {
+            std::cout << "   " << std::left << std::setw(24) << ends[0][i].first << std::right << " ticked=0x" << std::hex
+                      << ends[0][i].second << "  warped=0x" << ends[1][i].second << std::dec << "\n";
+        }
+    }
+    if (diffs) {
+        std::cout << "❌ " << workload.name << ": " << diffs << " values differ after " << cycles << " cycles\n";
+        return false;
+    }
+    if (!warps) {
+        std::cout << "❌ " << workload.name << ": the time warp never fired, nothing was checked\n";
+        return false;
+    }
+    std::cout << "✅ " << std::left << std::setw(17) << workload.name << std::right << " identical after " << cycles
+              << " cycles (" << warped << " warped in " << warps << " warps)\n";
+    return true;
+}
 
 int main(int argc, char **argv) {
     Verilated::commandArgs(argc, argv);
-    VRV64GC_optimized* cpu = new VRV64GC_optimized;
-    
-    // Reset CPU
-    cpu->rst = 1;
-    cpu->clk = 0;
-    cpu->eval();
-    cpu->clk = 1;
-    cpu->eval();
-    cpu->rst = 0;
-    
-    std::cout << "🚀 FAST BOY HYBRID CPU - CLOCK BENCHMARK 🚀\n";
-    std::cout << "============================================\n\n";
-    
-    const int benchmark_cycles = 1000000; // 1 million cycles
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
-    
-    // Run benchmark cycles
-    for (int cycle = 0; cycle < benchmark_cycles; cycle++) {
-        // Positive edge
-        cpu->clk = 1;
-        cpu->eval();
-        
-        // Negative edge  
-        cpu->clk = 0;
-        cpu->eval();
-    }
-    
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-    
-    double elapsed_seconds = duration.count() / 1000000.0;
-    double cycles_per_second = benchmark_cycles / elapsed_seconds;
-    double mhz = cycles_per_second / 1000000.0;
-    
-    std::cout << "📊 BENCHMARK RESULTS:\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "Total Cycles:        " << std::setw(12) << benchmark_cycles << "\n";
-    std::cout << "Elapsed Time:        " << std::setw(12) << std::fixed << std::setprecision(6) << elapsed_seconds << " seconds\n";
-    std::cout << "Cycles/Second:       " << std::setw(12) << std::fixed << std::setprecision(0) << cycles_per_second << "\n";
-    std::cout << "Simulated Clock:     " << std::setw(12) << std::fixed << std::setprecision(3) << mhz << " MHz\n";
+
+    uint64_t cycles = 1000000;
+    int trials = 10;
+    int warmup = 2;
+    std::string label = "default";
+    const char* json_path = nullptr;
+    uint64_t profile_every = 0; // 0 = profiler off
+    bool time_warp = false;
+    bool check_warp = false;
+    std::vector<std::string> selected;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--cycles") && has_value) {
+            cycles = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--trials") && has_value) {
+            trials = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--warmup") && has_value) {
+            warmup = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--workload") && has_value) {
+            selected.push_back(argv[++i]);
+        } else if (!strcmp(argv[i], "--label") && has_value) {
+            label = argv[++i];
+        } else if (!strcmp(argv[i], "--json") && has_value) {
+            json_path = argv[++i];
+        } else if (!strcmp(argv[i], "--profile-every") && has_value) {
+            profile_every = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--time-warp")) {
+            time_warp = true;
+        } else if (!strcmp(argv[i], "--check-warp")) {
+            check_warp = true;
+        } else if (argv[i][0] != '+') {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (cycles == 0 || trials < 1 || warmup < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Workload> workloads;
+    for (const Workload& w : make_workloads()) {
+        if (selected.empty() || std::find(selected.begin(), selected.end(), w.name) != selected.end()) {
+            workloads.push_back(w);
+        }
+    }
+    if (workloads.empty()) {
+        std::cerr << "❌ No matching workloads (riscv_alu, riscv_loop, console_print, riscv_vector, x86_alu, x86_sse, mixed_switch, dual_concurrent, idle_wfi, idle_sled, print_idle_sled, x86_idle_sled)\n";
+        return 1;
+    }
+
+    if (check_warp) {
+        std::cout << "⏩ Time warp check: ticked vs warped, " << cycles << " cycles per workload\n";
+        int failed = 0;
+        for (const Workload& w : workloads) {
+            if (!check_time_warp(w, cycles)) failed++;
+        }
+        return failed ? 1 : 0;
+    }
+
+    std::cout << "🚀 FAST BOY HYBRID CPU - BENCHMARK SUITE 🚀\n";
+    std::cout << "============================================\n";
+    std::cout << "Config: " << label << "   " << cycles << " cycles x " << trials
+              << " trials (+" << warmup << " warmup)";
+    if (profile_every) std::cout << "   PC profiler: 1 sample per " << profile_every << " cycles";
+    if (time_warp) std::cout << "   ⏩ time warp on";
+    std::cout << "\n\n";
+
+    for (const Workload& w : workloads) {
+        std::cout << "  " << std::left << std::setw(17) << w.name << std::right << w.description << "\n";
+    }
     std::cout << "\n";
-    
-    // Performance rating
-    if (mhz > 50) {
-        std::cout << "🔥 PERFORMANCE: BLAZING FAST! 🔥\n";
-    } else if (mhz > 10) {
-        std::cout << "⚡ PERFORMANCE: VERY FAST! ⚡\n";
-    } else if (mhz > 1) {
-        std::cout << "🚀 PERFORMANCE: FAST! 🚀\n";
-    } else {
-        std::cout << "🐌 PERFORMANCE: OPTIMIZABLE\n";
-    }
-    
-    std::cout << "\n🎯 CPU STATE AFTER BENCHMARK:\n";
-    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-    std::cout << "PC:           0x" << std::hex << std::setw(16) << std::setfill('0') << cpu->pc << std::dec << "\n";
-    std::cout << "Register Out: 0x" << std::hex << std::setw(16) << std::setfill('0') << cpu->reg_out << std::dec << "\n";
-    std::cout << "Debug Instr:  0x" << std::hex << std::setw(8) << std::setfill('0') << cpu->debug_instr << std::dec << "\n";
-    
-    delete cpu;
+
+    std::cout << std::left << std::setw(17) << "Workload" << std::right
+              << std::setw(12) << "Median MHz" << std::setw(12) << "p99 MHz" << std::setw(12) << "Best MHz"
+              << std::setw(8) << "IPC" << std::setw(13) << "Median MIPS"
+              << std::setw(10) << "Switches" << std::setw(10) << "Skipped" << "\n";
+    std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+
+    std::vector<WorkloadResult> results;
+    for (const Workload& w : workloads) {
+        WorkloadResult r = benchmark_workload(w, cycles, warmup, trials, profile_every, time_warp);
+        double ipc = ratio(r.perf.minstret, r.perf.mcycle);
+        std::cout << std::left << std::setw(17) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << r.median_cps / 1e6 << std::setw(12) << r.p99_cps / 1e6
+                  << std::setw(12) << r.best_cps / 1e6 << std::setw(8) << ipc
+                  << std::setw(13) << r.median_cps * ipc / 1e6 << std::setw(10) << r.perf.mode_switches << std::setw(10) << r.perf.unknown_skips << "\n";
+        results.push_back(r);
+    }
+
+    // RISC-V pipeline behaviour, for comparing predictor builds (make predictor_sweep)
+    std::cout << "\nRISC-V pipeline (" << bp_scheme_name(results.front().bp_scheme) << " predictor):\n";
+    std::cout << std::left << std::setw(17) << "Workload" << std::right << std::setw(10) << "RV IPC"
+              << std::setw(12) << "Stalls" << std::setw(12) << "Flushes" << std::setw(12) << "Branches"
+              << std::setw(12) << "Mispredict" << std::setw(10) << "Rate" << "\n";
+    for (const WorkloadResult& r : results) {
+        const PerfCounters& p = r.perf;
+        if (!p.rv_mcycle) continue;
+        std::cout << std::left << std::setw(17) << r.name << std::right << std::setw(10) << ratio(p.rv_minstret, p.rv_mcycle)
+                  << std::setw(12) << p.rv_stall_cycles << std::setw(12) << p.rv_flushes << std::setw(12) << p.rv_branches
+                  << std::setw(12) << p.rv_mispredicts << std::setw(9) << ratio(p.rv_mispredicts, p.rv_branches) * 100 << "%\n";
+    }
+
+    // Shared L1I / L1D behaviour (mode switches show up as L1I evictions)
+    std::cout << "\nL1 caches:\n";
+    std::cout << std::left << std::setw(17) << "Workload" << std::right << std::setw(10) << "L1I hit"
+              << std::setw(12) << "Misses" << std::setw(12) << "Evictions" << std::setw(10) << "L1D hit"
+              << std::setw(12) << "Misses" << std::setw(12) << "Evictions" << "\n";
+    for (const WorkloadResult& r : results) {
+        const PerfCounters& p = r.perf;
+        std::cout << std::left << std::setw(17) << r.name << std::right
+                  << std::setw(9) << hit_rate(p.l1i_hits, p.l1i_misses) << "%" << std::setw(12) << p.l1i_misses
+                  << std::setw(12) << p.l1i_evictions << std::setw(9) << hit_rate(p.l1d_hits, p.l1d_misses) << "%"
+                  << std::setw(12) << p.l1d_misses << std::setw(12) << p.l1d_evictions << "\n";
+    }
+
+    // SIMD work per instruction and how evenly it spread over the 32-bit lanes
+    bool simd_header = false;
+    for (const WorkloadResult& r : results) {
+        const PerfCounters& p = r.perf;
+        uint64_t ops = p.rv_simd_ops + p.x86_simd_ops;
+        if (!ops) continue;
+        if (!simd_header) {
+            std::cout << "\nSIMD units:\n";
+            std::cout << std::left << std::setw(17) << "Workload" << std::right << std::setw(12) << "SIMD ops"
+                      << std::setw(12) << "Elem/op" << std::setw(32) << "Lane utilization 0..3" << "\n";
+            simd_header = true;
+        }
+        std::cout << std::left << std::setw(17) << r.name << std::right << std::setw(12) << ops
+                  << std::setw(12) << ratio(p.rv_simd_elements + p.x86_simd_elements, ops) << "    ";
+        for (int lane = 0; lane < VEC_LANES; lane++) std::cout << std::setw(6) << lane_utilization(p, lane) << "%";
+        std::cout << "\n";
+    }
+
+    // Share of each trial the time warp skipped instead of ticking
+    if (time_warp) {
+        std::cout << "\n⏩ Time warp:\n";
+        std::cout << std::left << std::setw(17) << "Workload" << std::right << std::setw(14) << "Warped"
+                  << std::setw(10) << "Share" << std::setw(10) << "Warps" << std::setw(14) << "Idle cycles" << "\n";
+        for (const WorkloadResult& r : results) {
+            const PerfCounters& p = r.perf;
+            std::cout << std::left << std::setw(17) << r.name << std::right << std::setw(14) << r.warped_cycles
+                      << std::setw(9) << ratio(r.warped_cycles, cycles) * 100 << "%" << std::setw(10) << r.warps
+                      << std::setw(14) << p.rv_idle_cycles + p.x86_idle_cycles << "\n";
+        }
+    }
+
+    // Guest console output and the host writes it cost (batched by GuestConsole)
+    for (const WorkloadResult& r : results) {
+        if (!r.console_bytes) continue;
+        std::cout << "\nConsole: " << r.name << " printed " << r.console_bytes << " bytes in "
+                  << r.console_flushes << " host writes (" << r.perf.console_overruns << " FIFO overruns)\n";
+    }
+
+    if (json_path) {
+        if (!write_json(json_path, label, cycles, warmup, trials, profile_every, time_warp, results)) {
+            std::cerr << "❌ Cannot write " << json_path << "\n";
+            return 1;
+        }
+        std::cout << "\n📄 Results written to " << json_path << "\n";
+    }
     return 0;
 }
@@ -0,0 +1,170 @@
+// FAST Hybrid CPU - functional model co-simulation
+// Fast-forwards a guest through the C++ ISA model, hands the state to the RTL,
+// then runs both side by side: every RTL cycle, the model steps each core that
+// committed (or skipped) an instruction, and the architectural state is compared.
+//
+// Usage: cosim [--fast-forward N] [--lockstep N] [--x86] [--concurrent] [program]
+//
+// <program> is an ELF64 image or flat binary (see program_loader.h); without
+// one the built-in demo program runs. --x86 starts a flat binary in
+// x86 mode, --concurrent runs both cores every cycle. Exit status is 1 on the
+// first divergence. Guest console output goes to stdout: the model prints it
+// while fast-forwarding, the RTL UART during lockstep.
+
+#include "hybrid_model.h"
+#include "isa_model.h"
+#include "program_loader.h"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Print every field that differs between the RTL and the model; returns the count
+static int report_divergence(VRV64GC_optimized* cpu, const HybridIsaModel& model) {
+    CpuState rtl = capture_state(cpu);
+    PerfCounters perf = capture_counters(cpu);
+    int diffs = 0;
+
+    auto check = [&diffs](const char* name, uint64_t rtl_value, uint64_t model_value) {
+        if (rtl_value == model_value) return;
+        fprintf(stderr, "   %-14s rtl=0x%016" PRIx64 "  model=0x%016" PRIx64 "\n", name, rtl_value, model_value);
+        diffs++;
+    };
+
+    char name[16];
+    check("pc", rtl.pc, model.pc);
+    check("x86_rip", rtl.x86_rip, model.x86_rip);
+    check("x86_mode", rtl.x86_mode, model.x86_mode);
+    check("rv_active", rtl.rv_active, model.rv_active);
+    check("rv_idle", rtl.rv_idle, model.rv_idle);
+    check("x86_idle", rtl.x86_idle, model.x86_idle);
+    for (int i = 0; i < 32; i++) {
+        snprintf(name, sizeof(name), "x%d", i);
+        check(name, rtl.regs[i], model.regs[i]);
+    }
+    for (int i = 0; i < 16; i++) {
+        snprintf(name, sizeof(name), "x86_r%d", i);
+        check(name, rtl.x86_regs[i], model.x86_regs[i]);
+    }
+    for (int i = 0; i < 32; i++) {
+        snprintf(name, sizeof(name), "v%d.lo", i);
+        check(name, rtl.vregs[i][0], model.vregs[i][0]);
+        snprintf(name, sizeof(name), "v%d.hi", i);
+        check(name, rtl.vregs[i][1], model.vregs[i][1]);
+    }
+    check("vl", rtl.vl, model.vl);
+    check("vsew", rtl.vsew, model.vsew);
+    for (int i = 0; i < X86_XMM_REGS; i++) {
+        snprintf(name, sizeof(name), "xmm%d.lo", i);
+        check(name, rtl.xmm[i][0], model.xmm[i][0]);
+        snprintf(name, sizeof(name), "xmm%d.hi", i);
+        check(name, rtl.xmm[i][1], model.xmm[i][1]);
+    }
+    check("x86_rflags", cpu->x86_rflags, model.x86_rflags);
+    check("reg_out", cpu->reg_out, model.reg_out);
+    check("minstret", perf.minstret, model.perf.minstret);
+    check("unknown_skips", perf.unknown_skips, model.perf.unknown_skips);
+    return diffs;
+}
+
+static void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--fast-forward N] [--lockstep N] [--x86] [--concurrent] [program]\n";
+}
+
+int main(int argc, char **argv) {
+    Verilated::commandArgs(argc, argv);
+
+    uint64_t fast_forward = 0;
+    uint64_t lockstep = 100000;
+    bool raw_x86 = false;
+    bool concurrent = false;
+    const char* program_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--fast-forward") && i + 1 < argc) {
+            fast_forward = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--lockstep") && i + 1 < argc) {
+            lockstep = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--x86")) {
+            raw_x86 = true;
+        } else if (!strcmp(argv[i], "--concurrent")) {
+            concurrent = true;
+        } else if (argv[i][0] == '+') {
+            // Verilator plusargs, already consumed by commandArgs
+        } else if (!program_path) {
+            program_path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    GuestMemory memory;
+    GuestConsole console(STDOUT_FILENO);
+    std::unique_ptr<VRV64GC_optimized> cpu(new VRV64GC_optimized);
+    attach_memory(cpu.get(), &memory);
+    attach_console(cpu.get(), &console);
+    set_concurrent(cpu.get(), concurrent);
+    if (program_path) {
+        ProgramInfo info;
+        std::string error;
+        if (!load_program(cpu.get(), program_path, info, error, raw_x86)) {
+            std::cerr << "❌ " << error << "\n";
+            return 1;
+        }
+    } else {
+        load_builtin_program(cpu.get());
+    }
+
+    std::unique_ptr<HybridIsaModel> model(new HybridIsaModel);
+    model->load_from_rtl(cpu.get());
+
+    // Phase 1: functional fast-forward (N instruction steps), then hand the state over to the RTL
+    if (fast_forward) {
+        auto start = std::chrono::steady_clock::now();
+        model->console = &console;
+        model->run(fast_forward);
+        model->console = nullptr; // The RTL UART prints from here on
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t retired = model->perf.minstret;
+        model->store_to_rtl(cpu.get());
+        std::cerr << "⏩ Fast-forwarded " << fast_forward << " steps (" << retired << " instructions) in "
+                  << seconds << " s = " << (seconds > 0 ? fast_forward / seconds / 1e6 : 0)
+                  << " M steps/s functional\n";
+    }
+
+    // Phase 2: lockstep. Each core commits at most one instruction per cycle
+    // (retired or skipped), but pipeline and cache stalls decide which cycle,
+    // so the model follows each core's commits rather than raw cycles.
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t cycle = 0; cycle < lockstep; cycle++) {
+        uint64_t pc = model->pc;
+        uint64_t rip = model->x86_rip;
+        uint64_t rv_commits = cpu->rv_minstret + cpu->rv_unknown_skips;
+        uint64_t x86_commits = cpu->x86_minstret + cpu->x86_unknown_skips;
+        tick(cpu.get());
+        bool rv_committed = cpu->rv_minstret + cpu->rv_unknown_skips != rv_commits;
+        bool x86_committed = cpu->x86_minstret + cpu->x86_unknown_skips != x86_commits;
+        if (!rv_committed && !x86_committed) continue; // Pipeline fill, stall or cache miss
+        model->step(rv_committed, x86_committed);
+
+        if (report_divergence(cpu.get(), *model)) {
+            fprintf(stderr, "❌ Divergence at lockstep cycle %" PRIu64 " (PC was 0x%" PRIx64 ", RIP 0x%" PRIx64
+                            ", last instruction 0x%08x)\n", cycle, pc, rip, model->last_instr);
+            return 1;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    console.flush();
+
+    CpuState final_state = capture_state(cpu.get());
+    printf("✅ %" PRIu64 " lockstep cycles, %" PRIu64 " instructions retired, no divergence\n",
+           lockstep, model->perf.minstret);
+    printf("   final PC 0x%" PRIx64 " RIP 0x%" PRIx64 "  (%.2f MHz in lockstep)\n",
+           final_state.pc, final_state.x86_rip, seconds > 0 ? lockstep / seconds / 1e6 : 0);
+    return 0;
+}
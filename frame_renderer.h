@@ -0,0 +1,213 @@
+// FAST Hybrid CPU - diff-based terminal frame renderer
+// Screens are drawn into a back grid of cells; present() compares it with the
+// grid currently on the terminal and emits only cursor moves plus changed text,
+// as one buffered write(2). All buffers are sized up front, so steady-state
+// frames never touch the heap.
+
+#pragma once
+
+#include <cerrno>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+
+class FrameRenderer {
+private:
+    // One terminal column. Wide glyphs (emoji) use a lead cell plus a
+    // zero-length continuation cell so columns stay aligned with the terminal.
+    struct Cell {
+        char bytes[15]; // One code point plus any combining/variation selectors
+        uint8_t len;    // 0 = continuation of the wide glyph to the left
+
+        bool operator==(const Cell& other) const {
+            return len == other.len && memcmp(bytes, other.bytes, len) == 0;
+        }
+    };
+
+    int rows;
+    int cols;
+    std::vector<Cell> back;   // Frame being drawn
+    std::vector<Cell> front;  // Frame currently on the terminal
+    std::vector<char> out;    // Escape sequences + text for one present()
+    size_t out_len;
+    int cursor_row;
+    int cursor_col;
+    bool clear_pending;
+
+public:
+    FrameRenderer(int row_count = 40, int col_count = 100)
+        : rows(row_count), cols(col_count), back(row_count * col_count), front(row_count * col_count),
+          out(static_cast<size_t>(row_count) * col_count * 24 + 4096), out_len(0),
+          cursor_row(0), cursor_col(0), clear_pending(true) {
+        invalidate();
+    }
+
+    // Forget what is on the terminal (after other code wrote to it). The next
+    // present() clears the screen, so the front grid becomes all blanks.
+    void invalidate() {
+        for (Cell& c : front) {
+            c.bytes[0] = ' ';
+            c.len = 1;
+        }
+        clear_pending = true;
+    }
+
+    void begin_frame() {
+        for (Cell& c : back) {
+            c.bytes[0] = ' ';
+            c.len = 1;
+        }
+    }
+
+    // Write UTF-8 text starting at (row, col); returns the column after it
+    int put(int row, int col, const char* text) {
+        if (row < 0 || row >= rows) return col;
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+        Cell* line = &back[row * cols];
+
+        while (*p && col < cols) {
+            int n = utf8_length(*p);
+            uint32_t cp = decode(p, n);
+
+            // Combining marks and variation selectors attach to the previous glyph
+            if ((cp == 0xFE0F || cp == 0x200D || (cp >= 0x0300 && cp <= 0x036F)) && col > 0) {
+                Cell& prev = line[col - 1].len ? line[col - 1] : line[col > 1 ? col - 2 : 0];
+                if (prev.len + n <= static_cast<int>(sizeof(prev.bytes))) {
+                    memcpy(prev.bytes + prev.len, p, n);
+                    prev.len += n;
+                }
+                p += n;
+                continue;
+            }
+
+            int width = is_wide(cp) ? 2 : 1;
+            if (col + width > cols) break;
+            memcpy(line[col].bytes, p, n);
+            line[col].len = static_cast<uint8_t>(n);
+            if (width == 2) line[col + 1].len = 0;
+            col += width;
+            p += n;
+        }
+        return col;
+    }
+
+    // printf-style put() through a stack buffer
+    int print(int row, int col, const char* fmt, ...) __attribute__((format(printf, 4, 5))) {
+        char text[512];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(text, sizeof(text), fmt, args);
+        va_end(args);
+        return put(row, col, text);
+    }
+
+    // Where the terminal cursor is left after present()
+    void set_cursor(int row, int col) {
+        cursor_row = row;
+        cursor_col = col;
+    }
+
+    // Emit the difference to the previous frame in a single write
+    void present() {
+        out_len = 0;
+        append("\033[?25l"); // Hide cursor while updating
+        if (clear_pending) {
+            append("\033[H\033[2J");
+            clear_pending = false;
+        }
+
+        for (int row = 0; row < rows; row++) {
+            Cell* b = &back[row * cols];
+            Cell* f = &front[row * cols];
+            int col = 0;
+            while (col < cols) {
+                if (b[col] == f[col]) {
+                    col++;
+                    continue;
+                }
+
+                // Start of a changed run; back up to the lead of a wide glyph
+                int start = col;
+                if (b[start].len == 0 && start > 0) start--;
+
+                // Extend through short unchanged gaps, a cursor move costs more
+                int end = col + 1;
+                int gap = 0;
+                while (end < cols && gap < 6) {
+                    gap = (b[end] == f[end]) ? gap + 1 : 0;
+                    end++;
+                }
+                end -= gap;
+
+                append_cursor(row, start);
+                for (int i = start; i < end; i++) {
+                    append_bytes(b[i].bytes, b[i].len);
+                    f[i] = b[i];
+                }
+                col = end;
+            }
+        }
+
+        append_cursor(cursor_row, cursor_col);
+        append("\033[?25h");
+        flush();
+    }
+
+private:
+    static int utf8_length(unsigned char lead) {
+        if (lead < 0x80) return 1;
+        if ((lead >> 5) == 0x6) return 2;
+        if ((lead >> 4) == 0xE) return 3;
+        if ((lead >> 3) == 0x1E) return 4;
+        return 1; // Invalid lead byte, pass through as a single cell
+    }
+
+    static uint32_t decode(const unsigned char* p, int n) {
+        if (n == 1) return p[0];
+        uint32_t cp = p[0] & (0xFF >> (n + 1));
+        for (int i = 1; i < n; i++) {
+            if ((p[i] & 0xC0) != 0x80) return 0xFFFD;
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        return cp;
+    }
+
+    // Emoji and pictographs render two columns wide in modern terminals
+    static bool is_wide(uint32_t cp) {
+        return (cp >= 0x1F300 && cp <= 0x1FAFF) || (cp >= 0x2600 && cp <= 0x27BF && cp != 0x2713);
+    }
+
+    void append_bytes(const char* bytes, size_t n) {
+        if (out_len + n > out.size()) flush(); // Only on pathological frames
+        memcpy(out.data() + out_len, bytes, n);
+        out_len += n;
+    }
+
+    void append(const char* text) { append_bytes(text, strlen(text)); }
+
+    void append_cursor(int row, int col) {
+        char seq[24];
+        int n = snprintf(seq, sizeof(seq), "\033[%d;%dH", row + 1, col + 1);
+        append_bytes(seq, static_cast<size_t>(n));
+    }
+
+    void flush() {
+        size_t done = 0;
+        while (done < out_len) {
+            ssize_t n = write(STDOUT_FILENO, out.data() + done, out_len - done);
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+                // The tty may share stdin's O_NONBLOCK flag; wait until it drains
+                struct pollfd pfd = {STDOUT_FILENO, POLLOUT, 0};
+                poll(&pfd, 1, 10);
+                continue;
+            }
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        out_len = 0;
+    }
+};
@@ -1,5 +1,15 @@
 #include "VRV64GC_optimized.h"
 #include "verilated.h"
+#include "program_loader.h"
+#include "checkpoint.h"
+#include "snapshot_buffer.h"
+#include "frame_renderer.h"
+#include "pc_profiler.h"
+#include "time_warp.h"
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdarg>
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -10,7 +20,29 @@
 #include <termios.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <random>
+
+// Architectural state published by the simulation thread after every chunk
+struct CpuSnapshot {
+    CpuState state;
+    uint64_t cycle;
+    uint64_t reg_out;
+    uint32_t debug_instr;
+    uint64_t x86_rflags;
+    PerfCounters perf;
+    unsigned bp_scheme;
+    double sim_mhz;
+    ProfileTop profile; // Refreshed with sim_mhz, not every chunk
+    ConsoleView console; // Refreshed when the guest printed something
+    uint64_t warped_cycles; // Skipped by the time warp (0 when it is off)
+    uint64_t warps;
+};
+
+// Simulation thread runs this many cycles between snapshots and command checks
+static const uint64_t SIM_CHUNK_CYCLES = 4096;
+static const auto UI_FRAME_INTERVAL = std::chrono::milliseconds(16); // ~60 fps
+
+enum SimCommand { SIM_CMD_NONE, SIM_CMD_SAVE, SIM_CMD_RESTORE };
+enum CheckpointState { CKPT_NONE, CKPT_PENDING, CKPT_SAVED, CKPT_RESTORED, CKPT_FAILED };
 
 // Fullscreen Terminal Simulator for Hybrid CPU
 class FullscreenSimulator {
@@ -25,32 +57,58 @@ private:
     struct termios old_termios;
     struct termios new_termios;
     
-    // Simulation state for dynamic display
-    std::mt19937 rng;
-    uint64_t simulation_cycle;
-    uint64_t simulated_x86_rip;
-    uint64_t simulated_x86_rax;
-    uint64_t simulated_x86_rcx;
-    uint64_t simulated_x86_rdx;
-    uint64_t simulated_x86_rflags;
-    bool simulated_x86_long_mode;
+    // Display state derived from the hardware counters
     int cpu_load_percent;
     
+    // Checkpoint/restore ([C] / [R] keys), executed on the simulation thread
+    std::string checkpoint_path;
+    std::atomic<int> checkpoint_state;
+    
+    // Free-running simulation thread; once started it is the only model user
+    std::thread sim_thread;
+    std::atomic<bool> sim_running;
+    std::atomic<bool> sim_paused;
+    std::atomic<int> sim_command;
+    SnapshotBuffer<CpuSnapshot> snapshots;
+    
+    // Guest PC sampling; the histogram is owned by the simulation thread
+    PcProfiler profiler;
+    ProfileTop profile_top;
+    bool show_profile; // [P] swaps the counter panel for the top functions
+    
+    // Idle/NOP-sled fast-forwarding (--time-warp), owned by the simulation thread
+    TimeWarp warp;
+    bool time_warp;
+    
+    // Guest console output (the UART's host side); flushed once per UI frame
+    // by the simulation thread, shown in the pane below the status box
+    GuestConsole* console;
+    ConsoleView console_view;
+    
+    // OS screens are drawn through a diff renderer (one write per frame)
+    FrameRenderer screen;
+    
 public:
-    FullscreenSimulator(VRV64GC_optimized* cpu_ptr) : cpu(cpu_ptr), running(true),
-                                           fullscreen_mode(false), current_os("BOOTLOADER"),
-                                           selected_menu_item(0), rng(std::chrono::steady_clock::now().time_since_epoch().count()),
-                                           simulation_cycle(0), simulated_x86_rip(0x400000), simulated_x86_rax(0x1234567890ABCDEF),
-                                           simulated_x86_rcx(0xFEDCBA0987654321), simulated_x86_rdx(0xDEADBEEFCAFEBABE),
-                                           simulated_x86_rflags(0x0000000000000002), simulated_x86_long_mode(true), cpu_load_percent(0) {
+    FullscreenSimulator(VRV64GC_optimized* cpu_ptr, const SymbolTable* symbols = nullptr,
+                        uint64_t profile_period = PROFILE_DEFAULT_PERIOD, bool use_time_warp = false)
+        : cpu(cpu_ptr), running(true),
+          fullscreen_mode(false), current_os("BOOTLOADER"),
+          selected_menu_item(0), cpu_load_percent(0),
+          checkpoint_path("hybridcpu64.ckpt"), checkpoint_state(CKPT_NONE),
+          sim_running(false), sim_paused(true), sim_command(SIM_CMD_NONE),
+          profiler(profile_period, symbols), profile_top(), show_profile(false),
+          warp(cpu_ptr), time_warp(use_time_warp),
+          console(attached_console(cpu_ptr)), console_view() {
         setup_terminal();
     }
     
     ~FullscreenSimulator() {
+        stop_simulation();
         restore_terminal();
     }
     
     void run() {
+        start_simulation();
         clear_screen();
         show_boot_screen();
         
@@ -63,9 +121,121 @@ public:
                 run_x86_os();
             }
         }
+        stop_simulation();
+    }
+    
+    // Flat profile + folded stacks of everything sampled so far (after run())
+    bool write_profile(const std::string& prefix) {
+        return profiler.write_reports(prefix);
     }
     
 private:
+    // === SIMULATION THREAD ===
+    void start_simulation() {
+        sim_running = true;
+        sim_thread = std::thread(&FullscreenSimulator::simulation_loop, this);
+    }
+    
+    void stop_simulation() {
+        sim_running = false;
+        if (sim_thread.joinable()) sim_thread.join();
+    }
+    
+    void simulation_loop() {
+        uint64_t cycle = 0;
+        uint64_t rate_cycles = 0;
+        double sim_mhz = 0;
+        auto rate_start = std::chrono::steady_clock::now();
+        auto last_flush = rate_start;
+        publish_snapshot(cycle, sim_mhz);
+        
+        while (sim_running.load(std::memory_order_relaxed)) {
+            int command = sim_command.exchange(SIM_CMD_NONE, std::memory_order_acquire);
+            if (command != SIM_CMD_NONE) {
+                run_checkpoint_command(command, cycle);
+                publish_snapshot(cycle, sim_mhz);
+            }
+            
+            if (sim_paused.load(std::memory_order_relaxed)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                rate_start = std::chrono::steady_clock::now();
+                rate_cycles = 0;
+                continue;
+            }
+            
+            if (time_warp) profiler.run(cpu, SIM_CHUNK_CYCLES, [this](uint64_t n) { warp.run(n); });
+            else profiler.run(cpu, SIM_CHUNK_CYCLES);
+            cycle += SIM_CHUNK_CYCLES;
+            rate_cycles += SIM_CHUNK_CYCLES;
+            
+            // Refresh the simulated clock rate a few times per second
+            auto now = std::chrono::steady_clock::now();
+            double elapsed = std::chrono::duration<double>(now - rate_start).count();
+            if (elapsed >= 0.25) {
+                sim_mhz = rate_cycles / elapsed / 1e6;
+                rate_cycles = 0;
+                rate_start = now;
+                profiler.top(profile_top);
+            }
+            if (console) {
+                if (now - last_flush >= UI_FRAME_INTERVAL) {
+                    console->flush();
+                    last_flush = now;
+                }
+                if (console->bytes() != console_view.total_bytes) console->view(console_view);
+            }
+            publish_snapshot(cycle, sim_mhz);
+        }
+    }
+    
+    void publish_snapshot(uint64_t cycle, double sim_mhz) {
+        CpuSnapshot& snap = snapshots.write_slot();
+        snap.state = capture_state(cpu);
+        snap.cycle = cycle;
+        snap.reg_out = cpu->reg_out;
+        snap.debug_instr = cpu->debug_instr;
+        snap.x86_rflags = cpu->x86_rflags;
+        snap.perf = capture_counters(cpu);
+        snap.bp_scheme = cpu->rv_bp_scheme;
+        snap.sim_mhz = sim_mhz;
+        snap.profile = profile_top;
+        snap.console = console_view;
+        snap.warped_cycles = warp.warped_cycles();
+        snap.warps = warp.warps();
+        snapshots.publish();
+    }
+    
+    void run_checkpoint_command(int command, uint64_t& cycle) {
+        std::string error;
+        if (command == SIM_CMD_SAVE) {
+            bool ok = save_checkpoint(cpu, checkpoint_path.c_str(), cycle, error);
+            checkpoint_state = ok ? CKPT_SAVED : CKPT_FAILED;
+        } else {
+            uint64_t restored_cycle = 0;
+            bool ok = restore_checkpoint(cpu, checkpoint_path.c_str(), restored_cycle, error);
+            if (ok) {
+                cycle = restored_cycle;
+                warp.reset();
+                // Samples and console output from before the restore no longer apply
+                profiler.clear();
+                profiler.top(profile_top);
+                if (console) {
+                    console->clear_view();
+                    console->view(console_view);
+                }
+            }
+            checkpoint_state = ok ? CKPT_RESTORED : CKPT_FAILED;
+        }
+    }
+    
+    // Sleep until the next UI frame so rendering runs at a fixed rate
+    void wait_for_frame(std::chrono::steady_clock::time_point& next_frame) {
+        next_frame += UI_FRAME_INTERVAL;
+        auto now = std::chrono::steady_clock::now();
+        if (next_frame < now) next_frame = now; // Fell behind, don't try to catch up
+        std::this_thread::sleep_until(next_frame);
+    }
+    
     void setup_terminal() {
         // Save old terminal settings
         tcgetattr(STDIN_FILENO, &old_termios);
@@ -166,138 +336,263 @@ private:
         std::cout << "  RISC-V OS loaded successfully!" << std::endl;
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
         
+        sim_paused = false;
+        std::cout.flush();
+        screen.invalidate();
+        auto next_frame = std::chrono::steady_clock::now();
         while (current_os == "RISC-V OS" && running) {
-            clear_screen();
             show_riscv_interface();
             
-            char key = get_key();
+            char key = poll_key();
             if (key == 's' || key == 'S') {
                 std::cout << "  Shutting down RISC-V OS..." << std::endl;
                 std::this_thread::sleep_for(std::chrono::milliseconds(1000));
                 current_os = "BOOTLOADER";
+            } else if (key == 'c' || key == 'C' || key == 'r' || key == 'R') {
+                handle_checkpoint_key(key);
+            } else if (key == 'p' || key == 'P') {
+                show_profile = !show_profile;
             } else if (key == 'q' || key == 'Q') {
                 running = false;
             }
+            wait_for_frame(next_frame);
         }
+        sim_paused = true;
     }
     
     void show_riscv_interface() {
-        // Advance simulation and make it dynamic
-        simulation_cycle++;
-        
-        // Simulate CPU execution with real clock cycles
-        for (int i = 0; i < 10; i++) {
-            cpu->clk = 0;
-            cpu->eval();
-            cpu->clk = 1;
-            cpu->eval();
-        }
+        // Sample the latest state from the simulation thread (never blocks it)
+        snapshots.refresh();
+        const CpuSnapshot& snap = snapshots.latest();
+        const PerfCounters& perf = snap.perf;
         
-        // Update CPU load simulation
-        cpu_load_percent = 30 + (simulation_cycle % 40);
+        // Load = share of RISC-V cycles that retired an instruction
+        double ipc = ratio(perf.rv_minstret, perf.rv_mcycle);
+        cpu_load_percent = static_cast<int>(ipc * 100 + 0.5);
         
-        // Simulate some realistic register changes
-        uint64_t x1_val = cpu->reg_out + (simulation_cycle * 4);
-        uint64_t x2_val = (cpu->reg_out ^ simulation_cycle) & 0xFFFFFFFF;
-        uint64_t current_pc = cpu->pc + (simulation_cycle % 16) * 4;
+        char load_bar[64];
+        format_load_bar(load_bar, sizeof(load_bar));
         
-        std::cout << "╔══════════════════════════════════════════════════════════════════════════════╗" << std::endl;
-        std::cout << "║                           🟢 RISC-V OS - RV64GC 🟢                        ║" << std::endl;
-        std::cout << "╠══════════════════════════════════════════════════════════════════════════════╣" << std::endl;
-        std::cout << "║                                                                              ║" << std::endl;
-        std::cout << "║  CPU Status: [RUNNING]                          Cycle: " << std::setw(10) << simulation_cycle << "          ║" << std::endl;
-        std::cout << "║    Mode: RISC-V (RV64GC) - 64-bit RISC-V Core                               ║" << std::endl;
-        std::cout << "║    PC: 0x" << std::hex << std::setw(16) << std::setfill('0') << current_pc << std::dec << "                                 ║" << std::endl;
-        std::cout << "║    X1 (ra): 0x" << std::hex << std::setw(16) << std::setfill('0') << x1_val << std::dec << "                           ║" << std::endl;
-        std::cout << "║    X2 (sp): 0x" << std::hex << std::setw(16) << std::setfill('0') << x2_val << std::dec << "                           ║" << std::endl;
-        std::cout << "║    X3 (gp): 0x" << std::hex << std::setw(16) << std::setfill('0') << (x1_val + x2_val) << std::dec << "                           ║" << std::endl;
-        std::cout << "║    Instruction: " << std::hex << std::setw(8) << std::setfill('0') << (cpu->debug_instr | (simulation_cycle & 0xFF)) << std::dec << "     Type: " << get_instr_type() << "                    ║" << std::endl;
-        std::cout << "║    CPU Load: [" << get_load_bar() << "] " << std::setw(3) << cpu_load_percent << "%                                  ║" << std::endl;
-        std::cout << "║                                                                              ║" << std::endl;
-        std::cout << "║  Performance Metrics:                                                       ║" << std::endl;
-        std::cout << "║    IPC: 1." << (simulation_cycle % 10) << "    Clock: " << std::setw(4) << (1000 + (simulation_cycle % 500)) << "MHz    Cache Hit: " << (90 + (simulation_cycle % 10)) << "%           ║" << std::endl;
-        std::cout << "║                                                                              ║" << std::endl;
-        std::cout << "║  Available Commands:                                                        ║" << std::endl;
-        std::cout << "║    [S] Shutdown RISC-V OS                                                   ║" << std::endl;
-        std::cout << "║    [Q] Quit Simulator                                                       ║" << std::endl;
-        std::cout << "║                                                                              ║" << std::endl;
-        std::cout << "║  Command: ";
-        std::cout.flush();
+        screen.begin_frame();
+        box_border(0, "╔", "╗");
+        box_line(1, "                           🟢 RISC-V OS - RV64GC 🟢");
+        box_border(2, "╠", "╣");
+        box_warp_line(3, snap);
+        box_line(4, "  CPU Status: [%-7s]   Sim: %8.2f MHz       Cycle: %12" PRIu64,
+                 snap.state.rv_idle ? "WFI" : "RUNNING", snap.sim_mhz, snap.cycle);
+        box_line(5, "    Mode: %s", snap.state.x86_mode ? "x86-64 (switched by 0xDEADBEEF)" : "RISC-V (RV64GC) - 64-bit RISC-V Core");
+        box_line(6, "    PC: 0x%016" PRIx64, snap.state.pc);
+        box_line(7, "    X1 (ra): 0x%016" PRIx64, snap.state.regs[1]);
+        box_line(8, "    X2 (sp): 0x%016" PRIx64, snap.state.regs[2]);
+        box_line(9, "    X3 (gp): 0x%016" PRIx64, snap.state.regs[3]);
+        box_line(10, "    Instruction: %08" PRIx32 "     Type: %s", snap.debug_instr, riscv_instr_type(snap.debug_instr));
+        box_line(11, "    CPU Load: [%s] %3d%%", load_bar, cpu_load_percent);
+        if (show_profile) {
+            box_profile_panel(12, 5, snap.profile);
+        } else {
+            box_simd_line(12, "  Performance Counters:   Vector", perf.rv_simd_ops, perf.rv_simd_elements, perf);
+            box_line(13, "    IPC: %.3f    mcycle: %" PRIu64 "    minstret: %" PRIu64 "    idle: %" PRIu64,
+                     ipc, perf.rv_mcycle, perf.rv_minstret, perf.rv_idle_cycles);
+            box_line(14, "    IMM: %" PRIu64 "  ALU: %" PRIu64 "  MUL: %" PRIu64 "  Switches: %" PRIu64 "  Skipped: %" PRIu64,
+                     perf.class_retired[PERF_CLASS_RV_ALU_IMM], perf.class_retired[PERF_CLASS_RV_ALU_REG],
+                     perf.class_retired[PERF_CLASS_RV_MULDIV], perf.mode_switches, perf.unknown_skips);
+            box_line(15, "    Pipeline: stalls %" PRIu64 "  flushes %" PRIu64 "  mispredicts %" PRIu64 "/%" PRIu64 " (%s)",
+                     perf.rv_stall_cycles, perf.rv_flushes, perf.rv_mispredicts, perf.rv_branches,
+                     bp_scheme_name(snap.bp_scheme));
+            box_cache_line(16, perf);
+        }
+        box_line(17, "  Available Commands:");
+        box_line(18, "    [S] Shutdown RISC-V OS   [P] Counters / top functions");
+        box_line(19, "    [C] Save checkpoint   [R] Restore checkpoint   (last: %-8s)", checkpoint_status());
+        box_line(20, "    [Q] Quit Simulator");
+        box_line(21, " ");
+        box_line(22, "  Command: ");
+        box_border(23, "╚", "╝");
+        box_console_pane(25, snap.console);
+        screen.set_cursor(22, 12);
+        screen.present();
     }
     
     void run_x86_os() {
         std::cout << "  x86 OS loaded successfully!" << std::endl;
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
         
+        sim_paused = false;
+        std::cout.flush();
+        screen.invalidate();
+        auto next_frame = std::chrono::steady_clock::now();
         while (current_os == "X86 OS" && running) {
-            clear_screen();
             show_x86_interface();
             
-            char key = get_key();
+            char key = poll_key();
             if (key == 's' || key == 'S') {
                 std::cout << "  Shutting down x86 OS..." << std::endl;
                 std::this_thread::sleep_for(std::chrono::milliseconds(1000));
                 current_os = "BOOTLOADER";
+            } else if (key == 'c' || key == 'C' || key == 'r' || key == 'R') {
+                handle_checkpoint_key(key);
+            } else if (key == 'p' || key == 'P') {
+                show_profile = !show_profile;
             } else if (key == 'q' || key == 'Q') {
                 running = false;
             }
+            wait_for_frame(next_frame);
         }
+        sim_paused = true;
     }
     
     void show_x86_interface() {
-        // Advance simulation with dynamic x86 behavior
-        simulation_cycle++;
-        
-        // Simulate CPU execution with real clock cycles
-        for (int i = 0; i < 10; i++) {
-            cpu->clk = 0;
-            cpu->eval();
-            cpu->clk = 1;
-            cpu->eval();
-        }
+        // Sample the latest state from the simulation thread (never blocks it)
+        snapshots.refresh();
+        const CpuSnapshot& snap = snapshots.latest();
+        const PerfCounters& perf = snap.perf;
         
-        // Update simulated x86 state with realistic changes
-        simulated_x86_rip += 4 + (simulation_cycle % 8);
-        simulated_x86_rax = (simulated_x86_rax << 1) ^ (simulation_cycle * 0x123456);
-        simulated_x86_rcx += (simulation_cycle * 0xABCDEF);
-        simulated_x86_rdx = simulated_x86_rax ^ simulated_x86_rcx;
-        simulated_x86_rflags = 0x0000000000000202 | ((simulation_cycle % 16) << 4);
-        cpu_load_percent = 45 + (simulation_cycle % 35);
+        // Load = share of x86 cycles that retired an instruction
+        double ipc = ratio(perf.x86_minstret, perf.x86_mcycle);
+        cpu_load_percent = static_cast<int>(ipc * 100 + 0.5);
         
-        // Simulate some x86 instructions being executed
-        const char* current_instr = get_x86_instruction();
+        char load_bar[64];
+        char flags[8];
+        format_load_bar(load_bar, sizeof(load_bar));
+        format_flags(flags, sizeof(flags), snap.x86_rflags);
         
-        std::cout << "╔══════════════════════════════════════════════════════════════════════════════╗" << std::endl;
-        std::cout << "║                           🔵 x86 OS - x86-64 🔵                            ║" << std::endl;
-        std::cout << "╠══════════════════════════════════════════════════════════════════════════════╣" << std::endl;
-        std::cout << "║                                                                              ║" << std::endl;
-        std::cout << "║  CPU Status: [RUNNING]                          Cycle: " << std::setw(10) << simulation_cycle << "          ║" << std::endl;
-        std::cout << "║    Mode: x86-64 (Long Mode) - Intel/AMD Compatible                          ║" << std::endl;
-        std::cout << "║    RIP: 0x" << std::hex << std::setw(16) << std::setfill('0') << simulated_x86_rip << std::dec << "                                    ║" << std::endl;
-        std::cout << "║    RAX: 0x" << std::hex << std::setw(16) << std::setfill('0') << simulated_x86_rax << std::dec << "                                    ║" << std::endl;
-        std::cout << "║    RCX: 0x" << std::hex << std::setw(16) << std::setfill('0') << simulated_x86_rcx << std::dec << "                                    ║" << std::endl;
-        std::cout << "║    RDX: 0x" << std::hex << std::setw(16) << std::setfill('0') << simulated_x86_rdx << std::dec << "                                    ║" << std::endl;
-        std::cout << "║    RFLAGS: 0x" << std::hex << std::setw(16) << std::setfill('0') << simulated_x86_rflags << std::dec << "   [" << get_flags_str() << "]                       ║" << std::endl;
-        std::cout << "║    Current Instr: " << std::setw(20) << std::left << current_instr << std::right << "                                     ║" << std::endl;
-        std::cout << "║    CPU Load: [" << get_load_bar() << "] " << std::setw(3) << cpu_load_percent << "%                                  ║" << std::endl;
-        std::cout << "║                                                                              ║" << std::endl;
-        std::cout << "║  Performance Metrics:                                                       ║" << std::endl;
-        std::cout << "║    IPC: 2." << (simulation_cycle % 8) << "    Clock: " << std::setw(4) << (2400 + (simulation_cycle % 600)) << "MHz    Cache Hit: " << (94 + (simulation_cycle % 6)) << "%           ║" << std::endl;
-        std::cout << "║    Branch Pred: " << (88 + (simulation_cycle % 12)) << "%    TLB Hit: " << (96 + (simulation_cycle % 4)) << "%    Temp: " << (45 + (simulation_cycle % 20)) << "°C               ║" << std::endl;
-        std::cout << "║                                                                              ║" << std::endl;
-        std::cout << "║  Available Commands:                                                        ║" << std::endl;
-        std::cout << "║    [S] Shutdown x86 OS                                                      ║" << std::endl;
-        std::cout << "║    [Q] Quit Simulator                                                       ║" << std::endl;
-        std::cout << "║                                                                              ║" << std::endl;
-        std::cout << "║  Command: ";
-        std::cout.flush();
+        screen.begin_frame();
+        box_border(0, "╔", "╗");
+        box_line(1, "                           🔵 x86 OS - x86-64 🔵");
+        box_border(2, "╠", "╣");
+        box_warp_line(3, snap);
+        box_line(4, "  CPU Status: [%-7s]   Sim: %8.2f MHz       Cycle: %12" PRIu64,
+                 snap.state.x86_idle ? "HLT" : "RUNNING", snap.sim_mhz, snap.cycle);
+        box_line(5, "    Mode: %s", snap.state.x86_mode ? "x86-64 (Long Mode) - Intel/AMD Compatible" : "RISC-V (waiting for 0xDEADBEEF switch)");
+        box_line(6, "    RIP: 0x%016" PRIx64, snap.state.x86_rip);
+        box_line(7, "    RAX: 0x%016" PRIx64, snap.state.x86_regs[0]);
+        box_line(8, "    RCX: 0x%016" PRIx64, snap.state.x86_regs[1]);
+        box_line(9, "    RDX: 0x%016" PRIx64, snap.state.x86_regs[2]);
+        box_line(10, "    RFLAGS: 0x%016" PRIx64 "   [%s]", snap.x86_rflags, flags);
+        box_line(11, "    Current Instr: %08" PRIx32 "  %-20s", snap.debug_instr, x86_instr_name(snap.debug_instr));
+        box_line(12, "    CPU Load: [%s] %3d%%", load_bar, cpu_load_percent);
+        box_simd_line(13, "    SSE", perf.x86_simd_ops, perf.x86_simd_elements, perf);
+        if (show_profile) {
+            box_profile_panel(14, 4, snap.profile);
+        } else {
+            box_line(14, "  Performance Counters:");
+            box_line(15, "    IPC: %.3f    mcycle: %" PRIu64 "    minstret: %" PRIu64 "    idle: %" PRIu64,
+                     ipc, perf.x86_mcycle, perf.x86_minstret, perf.x86_idle_cycles);
+            box_line(16, "    ALU: %" PRIu64 "  NOP: %" PRIu64 "  OUT: %" PRIu64 "  Switches: %" PRIu64 "  Skipped: %" PRIu64,
+                     perf.class_retired[PERF_CLASS_X86_ALU], perf.class_retired[PERF_CLASS_X86_NOP],
+                     perf.class_retired[PERF_CLASS_X86_IO], perf.mode_switches, perf.unknown_skips);
+            box_cache_line(17, perf);
+        }
+        box_line(18, "  Available Commands:");
+        box_line(19, "    [S] Shutdown x86 OS   [P] Counters / top functions");
+        box_line(20, "    [C] Save checkpoint   [R] Restore checkpoint   (last: %-8s)", checkpoint_status());
+        box_line(21, "    [Q] Quit Simulator");
+        box_line(22, " ");
+        box_line(23, "  Command: ");
+        box_border(24, "╚", "╝");
+        box_console_pane(25, snap.console);
+        screen.set_cursor(23, 12);
+        screen.present();
     }
     
-    char get_key() {
+    // === FRAME HELPERS (draw into the renderer's back buffer) ===
+    static const int BOX_RIGHT = 79;
+    
+    void box_border(int row, const char* left, const char* right) {
+        screen.put(row, 0, left);
+        for (int col = 1; col < BOX_RIGHT; col++) screen.put(row, col, "═");
+        screen.put(row, BOX_RIGHT, right);
+    }
+    
+    void box_line(int row, const char* fmt, ...) __attribute__((format(printf, 3, 4))) {
+        char text[256];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(text, sizeof(text), fmt, args);
+        va_end(args);
+        screen.put(row, 0, "║");
+        screen.put(row, 1, text);
+        screen.put(row, BOX_RIGHT, "║"); // Drawn last so long text never breaks the box
+    }
+
+    // Shared L1 statistics, identical on both screens
+    void box_cache_line(int row, const PerfCounters& perf) {
+        box_line(row, "    L1I: %5.1f%% hit (%" PRIu64 " miss, %" PRIu64 " evict)   L1D: %5.1f%% hit (%" PRIu64 " miss)",
+                 hit_rate(perf.l1i_hits, perf.l1i_misses), perf.l1i_misses, perf.l1i_evictions,
+                 hit_rate(perf.l1d_hits, perf.l1d_misses), perf.l1d_misses);
+    }
+
+    // Share of the run the time warp skipped; blank when it is off
+    void box_warp_line(int row, const CpuSnapshot& snap) {
+        if (!time_warp) {
+            box_line(row, " ");
+            return;
+        }
+        box_line(row, "  ⏩ Time warp: %5.1f%% of cycles skipped in %" PRIu64 " warps",
+                 ratio(std::min(snap.warped_cycles, snap.cycle), snap.cycle) * 100, snap.warps); // Restores rewind cycle
+    }
+
+    // SIMD ops of one core; lane utilization covers both cores' SIMD units
+    void box_simd_line(int row, const char* label, uint64_t ops, uint64_t elements, const PerfCounters& perf) {
+        box_line(row, "%s: %" PRIu64 " ops  %.1f elem/op  lanes %3.0f%% %3.0f%% %3.0f%% %3.0f%%", label, ops,
+                 ratio(elements, ops), lane_utilization(perf, 0), lane_utilization(perf, 1),
+                 lane_utilization(perf, 2), lane_utilization(perf, 3));
+    }
+
+    // Header plus the heaviest functions, filling `rows` rows
+    void box_profile_panel(int row, int rows, const ProfileTop& top) {
+        box_line(row, "  Top Functions: %" PRIu64 " samples, 1 per %" PRIu64 " cycles",
+                 top.total_samples, top.period);
+        for (int i = 0; i < rows - 1; i++) {
+            if (i < top.rows) {
+                const ProfileTopEntry& e = top.entries[i];
+                box_line(row + 1 + i, "    %5.1f%%  %-5s  %-40s", ratio(e.samples, top.total_samples) * 100,
+                         e.x86 ? "x86" : "riscv", e.name);
+            } else {
+                box_line(row + 1 + i, " ");
+            }
+        }
+    }
+
+    // Guest console: the last CONSOLE_VIEW_ROWS lines, scrolling as output arrives
+    void box_console_pane(int row, const ConsoleView& view) {
+        box_border(row, "╔", "╗");
+        screen.print(row, 2, " Console (UART @ 0x%08" PRIx64 ", %" PRIu64 " bytes) ", CONSOLE_BASE, view.total_bytes);
+        for (int i = 0; i < CONSOLE_VIEW_ROWS; i++) {
+            box_line(row + 1 + i, " %s", view.lines[i]);
+        }
+        box_border(row + 1 + CONSOLE_VIEW_ROWS, "╚", "╝");
+    }
+
+    void handle_checkpoint_key(char key) {
+        checkpoint_state = CKPT_PENDING;
+        sim_command.store((key == 'c' || key == 'C') ? SIM_CMD_SAVE : SIM_CMD_RESTORE, std::memory_order_release);
+    }
+    
+    const char* checkpoint_status() {
+        switch (checkpoint_state.load()) {
+            case CKPT_PENDING: return "pending";
+            case CKPT_SAVED: return "saved";
+            case CKPT_RESTORED: return "restored";
+            case CKPT_FAILED: return "failed";
+            default: return "none";
+        }
+    }
+    
+    // Non-blocking key read for frame-paced loops
+    char poll_key() {
         char key = 0;
         if (read(STDIN_FILENO, &key, 1) > 0) {
             return key;
         }
+        return 0;
+    }
+    
+    char get_key() {
+        char key = poll_key();
+        if (key) {
+            return key;
+        }
         // Add small delay to prevent busy waiting
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
         return 0;
@@ -309,66 +604,155 @@ private:
         }
     }
     
-    std::string get_load_bar() {
+    void format_load_bar(char* out, size_t size) {
         int bars = cpu_load_percent / 5;
-        std::string result = "";
-        for (int i = 0; i < 20; i++) {
-            if (i < bars) result += "█";
-            else result += "░";
+        size_t len = 0;
+        for (int i = 0; i < 20 && len + 4 <= size; i++) {
+            memcpy(out + len, i < bars ? "█" : "░", 3);
+            len += 3;
         }
-        return result;
+        out[len] = '\0';
     }
     
-    std::string get_instr_type() {
-        const char* types[] = {"ALU", "LOAD", "STORE", "BRANCH", "IMM", "JUMP", "CSR", "MUL"};
-        return types[simulation_cycle % 8];
+    // Class of the last RISC-V instruction, as counted by the RTL
+    static const char* riscv_instr_type(uint32_t instr) {
+        if (instr == 0xDEADBEEF) return "SWITCH";
+        if (instr == 0x10500073) return "WFI";
+        switch (instr & 0x7F) {
+            case 0x13: return "IMM";
+            case 0x1B: return "IMM";
+            case 0x33:
+            case 0x3B: return (instr >> 25) == 0x01 ? "MUL" : "ALU";
+            case 0x37:
+            case 0x17: return "UPPER";
+            case 0x63: return "BRANCH";
+            case 0x6F:
+            case 0x67: return "JUMP";
+            case 0x03: return "LOAD";
+            case 0x23: return "STORE";
+            case 0x57: return ((instr >> 12) & 0x7) == 0x7 ? "VSETVLI" : "VECTOR";
+            case 0x07: return "VLOAD";
+            case 0x27: return "VSTORE";
+            default: return "SKIP";
+        }
     }
     
-    const char* get_x86_instruction() {
-        const char* instrs[] = {
-            "MOV RAX, RCX", "ADD RAX, 0x10", "CMP RDX, RAX", 
-            "JNE 0x401000", "PUSH RBP", "POP RBP", "CALL func", 
-            "RET", "XOR RAX, RAX", "LEA RDX, [RAX+4]",
-            "TEST RCX, RCX", "SHR RAX, 2"
-        };
-        return instrs[simulation_cycle % 12];
+    // Name of the last x86 word as decoded by execute_x86_fast/fast_x86_alu
+    static const char* x86_instr_name(uint32_t instr) {
+        switch (instr & 0xFF) {
+            case 0x48:
+                switch ((instr >> 8) & 0xFF) {
+                    case 0xC7: return "MOV r64, imm";
+                    case 0x01: return "ADD RAX, RCX";
+                    case 0xB0: return "MOV AL, imm8";
+                    case 0xE6: return "OUT imm8, AL";
+                    default: return "REX.W (no-op)";
+                }
+            case 0x90: return "NOP";
+            case 0xF4: return "HLT";
+            case 0x66:
+                if (((instr >> 16) & 0xFF) == 0xD4) return "PADDQ xmm, xmm";
+                if (((instr >> 16) & 0xFF) == 0x38) return "PMULLD xmm, xmm";
+                return "(unknown, skipped)";
+            case 0xF3:
+                if (((instr >> 16) & 0xFF) == 0x6F) return "MOVDQU xmm, m128";
+                if (((instr >> 16) & 0xFF) == 0x7F) return "MOVDQU m128, xmm";
+                return "(unknown, skipped)";
+            default: return "(unknown, skipped)";
+        }
     }
     
-    std::string get_flags_str() {
-        std::string flags = "";
-        if (simulated_x86_rflags & 0x1) flags += "C";
-        if (simulated_x86_rflags & 0x4) flags += "P";
-        if (simulated_x86_rflags & 0x40) flags += "Z";
-        if (simulated_x86_rflags & 0x80) flags += "S";
-        if (simulated_x86_rflags & 0x800) flags += "O";
-        if (flags.empty()) flags = "None";
-        return flags;
+    static void format_flags(char* out, size_t size, uint64_t rflags) {
+        size_t len = 0;
+        if (rflags & 0x1) out[len++] = 'C';
+        if (rflags & 0x4) out[len++] = 'P';
+        if (rflags & 0x40) out[len++] = 'Z';
+        if (rflags & 0x80) out[len++] = 'S';
+        if (rflags & 0x800) out[len++] = 'O';
+        out[len] = '\0';
+        if (len == 0) snprintf(out, size, "None");
     }
 };
 
 int main(int argc, char **argv) {
     Verilated::commandArgs(argc, argv);
-    VRV64GC_optimized* top = new VRV64GC_optimized;
     
-    // Initial reset
-    top->rst = 1;
-    top->clk = 0;
-    top->eval();
+    // ./VRV64GC_optimized [--profile prefix] [--profile-every N] [--huge-pages] [--console-log file]
+    //                     [--time-warp] [program.elf | program.bin]
+    const char* program_path = nullptr;
+    const char* profile_prefix = nullptr;
+    const char* console_log = nullptr;
+    uint64_t profile_period = PROFILE_DEFAULT_PERIOD;
+    bool huge_pages = false;
+    bool time_warp = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--huge-pages")) {
+            huge_pages = true;
+        } else if (!strcmp(argv[i], "--time-warp")) {
+            time_warp = true;
+        } else if (!strcmp(argv[i], "--profile") && i + 1 < argc) {
+            profile_prefix = argv[++i];
+        } else if (!strcmp(argv[i], "--profile-every") && i + 1 < argc) {
+            profile_period = strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--console-log") && i + 1 < argc) {
+            console_log = argv[++i];
+        } else if (argv[i][0] != '+') {
+            program_path = argv[i];
+        }
+    }
     
-    // Hold reset for one full clock cycle
-    top->clk = 1;
-    top->eval();
-    top->clk = 0;
-    top->eval();
+    // The screen belongs to the frame renderer, so guest output only goes to
+    // the console pane unless it is also logged to a file
+    int console_fd = -1;
+    if (console_log) {
+        console_fd = open(console_log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (console_fd < 0) {
+            std::cerr << "❌ Cannot create console log " << console_log << ": " << strerror(errno) << std::endl;
+            return 1;
+        }
+    }
     
-    // Release reset
-    top->rst = 0;
-    top->eval();
+    // Sparse guest address space and console, backing the model through DPI
+    GuestMemory memory(huge_pages);
+    GuestConsole console(console_fd);
+    VRV64GC_optimized* top = new VRV64GC_optimized;
+    attach_memory(top, &memory);
+    attach_console(top, &console);
+    
+    SymbolTable symbols;
+    if (program_path) {
+        // Loader copies the image in and performs the initial reset
+        ProgramInfo info;
+        std::string error;
+        if (!load_program(top, program_path, info, error)) {
+            std::cerr << "❌ Failed to load " << program_path << ": " << error << std::endl;
+            top->final();
+            delete top;
+            if (console_fd >= 0) close(console_fd);
+            return 1;
+        }
+        if (!symbols.load(program_path, error)) {
+            std::cerr << "⚠️  No symbols from " << program_path << ": " << error << std::endl;
+        }
+    } else {
+        // Built-in demo program, then hold reset for one full clock cycle
+        load_builtin_program(top);
+    }
 
     // Run fullscreen simulator
-    FullscreenSimulator simulator(top);
+    FullscreenSimulator simulator(top, &symbols, profile_period, time_warp);
     simulator.run();
+    if (profile_prefix) {
+        if (simulator.write_profile(profile_prefix)) {
+            std::cout << "📄 Profile written to " << profile_prefix << ".profile.txt / .folded" << std::endl;
+        } else {
+            std::cerr << "❌ Cannot write profile " << profile_prefix << std::endl;
+        }
+    }
     
+    top->final();
     delete top;
+    console.flush();
+    if (console_fd >= 0) close(console_fd);
     return 0;
 }
@@ -0,0 +1,136 @@
+// FAST Hybrid CPU - host side of the console UART
+// Bytes the UART (hybrid_uart.v) drains arrive here one at a time through DPI-C
+// (guest_console_dpi.cpp). They are only appended to a ring buffer; host I/O
+// happens in flush(), as one writev(2) of everything pending, which the owner
+// calls once per UI frame and which put() triggers itself every flush_bytes
+// bytes. The ring doubles as scrollback for the simulator's console pane.
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+// UART registers (mirror the CONSOLE_* defines in mem_constants.vh)
+static const uint64_t CONSOLE_BASE = 0x10000000;
+static const uint64_t CONSOLE_REG_THR = 0;
+static const uint64_t CONSOLE_REG_LSR = 5;
+static const uint64_t CONSOLE_LSR_IDLE = 0x60; // THRE | TEMT
+
+static const size_t CONSOLE_RING_BYTES = size_t(1) << 16;   // Scrollback + unflushed output
+static const size_t CONSOLE_DEFAULT_FLUSH_BYTES = 4096;
+static const int CONSOLE_VIEW_ROWS = 10;
+static const int CONSOLE_VIEW_COLS = 76;
+
+// Last lines of output, wrapped to the pane width (fixed size so it can
+// travel in simulator snapshots)
+struct ConsoleView {
+    uint64_t total_bytes;
+    char lines[CONSOLE_VIEW_ROWS][CONSOLE_VIEW_COLS + 1]; // Oldest first
+};
+
+class GuestConsole {
+private:
+    std::vector<char> ring;
+    uint64_t written;   // Bytes received so far
+    uint64_t flushed;   // Bytes already handed to fd
+    uint64_t flush_calls;
+    uint64_t view_from; // view() ignores bytes before this
+    int fd;             // -1 = keep output in the ring only
+    size_t flush_bytes;
+
+public:
+    // out_fd is not owned; flush_threshold is capped at the ring size so
+    // unflushed bytes are never overwritten
+    explicit GuestConsole(int out_fd = -1, size_t flush_threshold = CONSOLE_DEFAULT_FLUSH_BYTES)
+        : ring(CONSOLE_RING_BYTES), written(0), flushed(0), flush_calls(0), view_from(0), fd(out_fd),
+          flush_bytes(std::max<size_t>(1, std::min(flush_threshold, CONSOLE_RING_BYTES))) {}
+
+    ~GuestConsole() { flush(); }
+
+    GuestConsole(const GuestConsole&) = delete;
+    GuestConsole& operator=(const GuestConsole&) = delete;
+
+    uint64_t bytes() const { return written; }
+    uint64_t flushes() const { return flush_calls; } // Flushes that wrote something
+
+    void put(uint8_t byte) {
+        ring[written & (CONSOLE_RING_BYTES - 1)] = static_cast<char>(byte);
+        written++;
+        if (written - flushed >= flush_bytes) flush();
+    }
+
+    // Write everything pending (at most two ring segments) in one writev
+    void flush() {
+        if (written == flushed) return;
+        if (fd < 0) {
+            flushed = written;
+            return;
+        }
+        flush_calls++;
+        while (flushed < written) {
+            size_t start = flushed & (CONSOLE_RING_BYTES - 1);
+            size_t pending = written - flushed;
+            size_t first = std::min(pending, CONSOLE_RING_BYTES - start);
+            struct iovec iov[2] = {{ring.data() + start, first}, {ring.data(), pending - first}};
+            ssize_t n = writev(fd, iov, pending > first ? 2 : 1);
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+                struct pollfd pfd = {fd, POLLOUT, 0};
+                poll(&pfd, 1, 10);
+                continue;
+            }
+            if (n <= 0) {
+                flushed = written; // Output is gone (closed pipe); keep the ring usable
+                break;
+            }
+            flushed += static_cast<uint64_t>(n);
+        }
+    }
+
+    // Drop the scrollback (e.g. after a checkpoint restore rewinds the guest);
+    // bytes already received are still flushed to fd
+    void clear_view() {
+        flush();
+        view_from = written;
+    }
+
+    // Fill view with the last CONSOLE_VIEW_ROWS lines. Long lines wrap, \r and
+    // other control bytes are dropped, tabs become a space and non-ASCII bytes
+    // a '?' so every byte is one pane column.
+    void view(ConsoleView& out) const {
+        memset(out.lines, 0, sizeof(out.lines));
+        out.total_bytes = written;
+
+        // Nothing older than a full pane of wrapped text can be visible
+        uint64_t window = std::min<uint64_t>(static_cast<uint64_t>(CONSOLE_VIEW_ROWS) * CONSOLE_VIEW_COLS,
+                                             std::min<uint64_t>(written - view_from, CONSOLE_RING_BYTES));
+        int row = 0; // Ring of rows; `row` is the one being filled
+        int col = 0;
+        for (uint64_t pos = written - window; pos < written; pos++) {
+            char c = ring[pos & (CONSOLE_RING_BYTES - 1)];
+            if (c == '\n' || col == CONSOLE_VIEW_COLS) {
+                row = (row + 1) % CONSOLE_VIEW_ROWS;
+                memset(out.lines[row], 0, sizeof(out.lines[row]));
+                col = 0;
+                if (c == '\n') continue;
+            }
+            unsigned char uc = static_cast<unsigned char>(c);
+            if (c == '\t') c = ' ';
+            else if (uc >= 0x80) c = '?';
+            else if (uc < 0x20 || uc == 0x7F) continue;
+            out.lines[row][col++] = c;
+        }
+
+        // Rotate so the row being filled comes last
+        char ordered[CONSOLE_VIEW_ROWS][CONSOLE_VIEW_COLS + 1];
+        for (int i = 0; i < CONSOLE_VIEW_ROWS; i++) {
+            memcpy(ordered[i], out.lines[(row + 1 + i) % CONSOLE_VIEW_ROWS], sizeof(ordered[i]));
+        }
+        memcpy(out.lines, ordered, sizeof(ordered));
+    }
+};
@@ -0,0 +1,12 @@
+// FAST Hybrid CPU - DPI-C binding for the console UART
+// Implements the import declared in hybrid_uart.v. `handle` is the
+// GuestConsole* that attach_console() stored in the UART's console_handle; a
+// model without one attached drops its output.
+
+#include "VRV64GC_optimized__Dpi.h"
+#include "guest_console.h"
+
+void guest_console_tx(long long handle, int data) {
+    GuestConsole* console = reinterpret_cast<GuestConsole*>(static_cast<uintptr_t>(handle));
+    if (console) console->put(static_cast<uint8_t>(data));
+}
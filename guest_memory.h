@@ -0,0 +1,255 @@
+// FAST Hybrid CPU - sparse paged guest memory
+// The whole 64-bit guest address space, backed by host pages that are only
+// allocated when a guest (or loader) first writes to them; untouched memory
+// reads as zero without costing host RSS. The RTL reaches it through the DPI-C
+// imports in hybrid_mem_arbiter.v (guest_memory_dpi.cpp).
+//
+// Each access port (RISC-V fetch, x86 fetch, data, host) has its own small
+// direct-mapped software TLB of page pointers, so sequential fetches and loads
+// skip the page-table walk. Reads of unmapped pages are cached as read-only
+// entries pointing at a shared zero page; the first write replaces them.
+//
+// Huge-page mode uses 2 MiB guest pages backed by transparent huge pages,
+// trading RSS granularity for TLB reach.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <unordered_map>
+#include <vector>
+
+static const unsigned GUEST_PAGE_SHIFT = 12;      // 4 KiB
+static const unsigned GUEST_HUGE_PAGE_SHIFT = 21; // 2 MiB
+static const size_t GUEST_ARENA_BYTES = size_t(1) << GUEST_HUGE_PAGE_SHIFT;
+static const int GUEST_TLB_ENTRIES = 16;          // Per port, direct-mapped
+
+// Access ports (mirror the MEM_PORT_* defines in mem_constants.vh)
+enum GuestMemPort {
+    GUEST_PORT_RV_FETCH = 0,
+    GUEST_PORT_X86_FETCH = 1,
+    GUEST_PORT_DATA = 2,
+    GUEST_PORT_HOST = 3, // Loaders, checkpoints, the ISA model's own accesses
+    GUEST_PORT_COUNT
+};
+
+class GuestMemory {
+private:
+    struct TlbEntry {
+        uint64_t vpn;   // ~0 = invalid
+        uint8_t* page;
+        bool writable;  // false = shared zero page, reads only
+    };
+
+    unsigned page_shift;
+    uint64_t offset_mask;
+    bool huge_pages;
+    std::unordered_map<uint64_t, uint8_t*> pages; // vpn -> host page
+    TlbEntry tlb[GUEST_PORT_COUNT][GUEST_TLB_ENTRIES];
+    uint64_t tlb_hit_count;
+    uint64_t tlb_miss_count;
+
+    // Pages are carved out of 2 MiB-aligned anonymous mappings; the kernel only
+    // backs the parts that get written
+    std::vector<uint8_t*> arenas;
+    uint8_t* arena_next;
+    size_t arena_left;
+
+    static const uint8_t* zero_page() {
+        static const uint8_t zeros[size_t(1) << GUEST_HUGE_PAGE_SHIFT] = {};
+        return zeros;
+    }
+
+public:
+    explicit GuestMemory(bool use_huge_pages = false)
+        : page_shift(use_huge_pages ? GUEST_HUGE_PAGE_SHIFT : GUEST_PAGE_SHIFT),
+          offset_mask((uint64_t(1) << page_shift) - 1), huge_pages(use_huge_pages),
+          tlb_hit_count(0), tlb_miss_count(0), arena_next(nullptr), arena_left(0) {
+        flush_tlb();
+    }
+
+    ~GuestMemory() { release(); }
+
+    GuestMemory(const GuestMemory&) = delete;
+    GuestMemory& operator=(const GuestMemory&) = delete;
+
+    size_t page_bytes() const { return size_t(1) << page_shift; }
+    size_t page_count() const { return pages.size(); }
+    size_t resident_bytes() const { return pages.size() * page_bytes(); }
+    bool huge() const { return huge_pages; }
+    uint64_t tlb_hits() const { return tlb_hit_count; }
+    uint64_t tlb_misses() const { return tlb_miss_count; }
+
+    // Host bytes of the page holding addr, or nullptr if it was never written
+    // (reads as zero). Bypasses the TLBs, for host-side scans (time_warp.h).
+    const uint8_t* find_page(uint64_t addr) const {
+        auto it = pages.find(addr >> page_shift);
+        return it == pages.end() ? nullptr : it->second;
+    }
+
+    // Drop every page (the address space reads as zero again)
+    void clear() {
+        release();
+        flush_tlb();
+    }
+
+    // Replace the contents with a copy of other (ISA model fast-forward, cosim)
+    void copy_from(const GuestMemory& other) {
+        if (&other == this) return;
+        clear();
+        other.for_each_page([this, &other](uint64_t addr, const uint8_t* data) {
+            write_bytes(addr, data, other.page_bytes());
+        });
+    }
+
+    // Calls fn(guest address, page bytes) for every allocated page, in address order
+    template <typename Fn>
+    void for_each_page(Fn fn) const {
+        std::vector<uint64_t> vpns;
+        vpns.reserve(pages.size());
+        for (const auto& entry : pages) vpns.push_back(entry.first);
+        std::sort(vpns.begin(), vpns.end());
+        for (uint64_t vpn : vpns) fn(vpn << page_shift, static_cast<const uint8_t*>(pages.at(vpn)));
+    }
+
+    // === ACCESSES (little-endian; accesses that cross a page go byte by byte) ===
+    uint32_t read32(uint64_t addr, int port = GUEST_PORT_HOST) {
+        if ((addr & offset_mask) <= offset_mask - 3) {
+            uint32_t value;
+            memcpy(&value, translate(addr, port, false), sizeof(value));
+            return value;
+        }
+        return static_cast<uint32_t>(read_split(addr, 4, port));
+    }
+
+    uint64_t read64(uint64_t addr, int port = GUEST_PORT_HOST) {
+        if ((addr & offset_mask) <= offset_mask - 7) {
+            uint64_t value;
+            memcpy(&value, translate(addr, port, false), sizeof(value));
+            return value;
+        }
+        return read_split(addr, 8, port);
+    }
+
+    // Store the low `bytes` bytes of value (1..8)
+    void write(uint64_t addr, uint64_t value, unsigned bytes, int port = GUEST_PORT_HOST) {
+        if ((addr & offset_mask) <= offset_mask - (bytes - 1)) {
+            memcpy(translate(addr, port, true), &value, bytes);
+            return;
+        }
+        for (unsigned i = 0; i < bytes; i++) *translate(addr + i, port, true) = static_cast<uint8_t>(value >> (i * 8));
+    }
+
+    // Bulk copy in; src == nullptr zero-fills, skipping pages that were never touched
+    void write_bytes(uint64_t addr, const uint8_t* src, uint64_t len) {
+        while (len) {
+            uint64_t chunk = std::min<uint64_t>(len, page_bytes() - (addr & offset_mask));
+            if (src) {
+                memcpy(translate(addr, GUEST_PORT_HOST, true), src, chunk);
+                src += chunk;
+            } else if (pages.count(addr >> page_shift)) {
+                memset(translate(addr, GUEST_PORT_HOST, true), 0, chunk);
+            }
+            addr += chunk;
+            len -= chunk;
+        }
+    }
+
+    void read_bytes(uint64_t addr, uint8_t* dst, uint64_t len) {
+        while (len) {
+            uint64_t chunk = std::min<uint64_t>(len, page_bytes() - (addr & offset_mask));
+            memcpy(dst, translate(addr, GUEST_PORT_HOST, false), chunk);
+            dst += chunk;
+            addr += chunk;
+            len -= chunk;
+        }
+    }
+
+private:
+    // Host pointer for addr. Writes need a real page; reads may get the zero page.
+    uint8_t* translate(uint64_t addr, int port, bool write) {
+        uint64_t vpn = addr >> page_shift;
+        TlbEntry& entry = tlb[port][vpn & (GUEST_TLB_ENTRIES - 1)];
+        if (entry.vpn == vpn && (entry.writable || !write)) {
+            tlb_hit_count++;
+            return entry.page + (addr & offset_mask);
+        }
+        tlb_miss_count++;
+        return walk(vpn, entry, write) + (addr & offset_mask);
+    }
+
+    uint8_t* walk(uint64_t vpn, TlbEntry& entry, bool write) {
+        auto it = pages.find(vpn);
+        uint8_t* page;
+        bool writable = true;
+        if (it != pages.end()) {
+            page = it->second;
+        } else if (write) {
+            page = allocate_page();
+            pages.emplace(vpn, page);
+            invalidate(vpn); // Other ports may cache the zero page for it
+        } else {
+            page = const_cast<uint8_t*>(zero_page()); // Never written through: writable = false
+            writable = false;
+        }
+        entry = TlbEntry{vpn, page, writable};
+        return page;
+    }
+
+    uint64_t read_split(uint64_t addr, unsigned bytes, int port) {
+        uint64_t value = 0;
+        for (unsigned i = 0; i < bytes; i++) value |= static_cast<uint64_t>(*translate(addr + i, port, false)) << (i * 8);
+        return value;
+    }
+
+    void invalidate(uint64_t vpn) {
+        for (auto& port_tlb : tlb) {
+            TlbEntry& entry = port_tlb[vpn & (GUEST_TLB_ENTRIES - 1)];
+            if (entry.vpn == vpn) entry.vpn = ~uint64_t(0);
+        }
+    }
+
+    void flush_tlb() {
+        for (auto& port_tlb : tlb) {
+            for (TlbEntry& entry : port_tlb) entry = TlbEntry{~uint64_t(0), nullptr, false};
+        }
+    }
+
+    uint8_t* allocate_page() {
+        if (arena_left < page_bytes()) new_arena();
+        uint8_t* page = arena_next;
+        arena_next += page_bytes();
+        arena_left -= page_bytes();
+        return page;
+    }
+
+    void new_arena() {
+        // Over-map by one alignment unit, then trim to a 2 MiB boundary
+        size_t align = size_t(1) << GUEST_HUGE_PAGE_SHIFT;
+        size_t map_bytes = GUEST_ARENA_BYTES + align;
+        void* raw = mmap(nullptr, map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (raw == MAP_FAILED) throw std::bad_alloc();
+
+        uint8_t* base = static_cast<uint8_t*>(raw);
+        uint8_t* aligned = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(base) + align - 1) & ~(align - 1));
+        if (aligned > base) munmap(base, aligned - base);
+        size_t tail = (base + map_bytes) - (aligned + GUEST_ARENA_BYTES);
+        if (tail) munmap(aligned + GUEST_ARENA_BYTES, tail);
+        if (huge_pages) madvise(aligned, GUEST_ARENA_BYTES, MADV_HUGEPAGE);
+
+        arenas.push_back(aligned);
+        arena_next = aligned;
+        arena_left = GUEST_ARENA_BYTES;
+    }
+
+    void release() {
+        for (uint8_t* arena : arenas) munmap(arena, GUEST_ARENA_BYTES);
+        arenas.clear();
+        pages.clear();
+        arena_next = nullptr;
+        arena_left = 0;
+    }
+};
@@ -0,0 +1,32 @@
+// FAST Hybrid CPU - DPI-C bindings for the sparse guest memory
+// Implements the imports declared in hybrid_mem_arbiter.v. `handle` is the
+// GuestMemory* that attach_memory() stored in the arbiter's mem_handle; a model
+// without one attached reads zeros and drops writes. `epoch` only exists so the
+// RTL re-evaluates its combinational reads after a store and is ignored here.
+//
+// Linked into every binary that contains the model (the simulator via
+// CPP_SOURCES, the headless tools on their compile lines).
+
+#include "VRV64GC_optimized__Dpi.h"
+#include "guest_memory.h"
+
+static inline GuestMemory* guest_memory(long long handle) {
+    return reinterpret_cast<GuestMemory*>(static_cast<uintptr_t>(handle));
+}
+
+int guest_mem_fetch(long long handle, int port, long long addr, int epoch) {
+    (void)epoch;
+    GuestMemory* memory = guest_memory(handle);
+    return memory ? static_cast<int>(memory->read32(static_cast<uint64_t>(addr), port)) : 0;
+}
+
+long long guest_mem_read64(long long handle, int port, long long addr, int epoch) {
+    (void)epoch;
+    GuestMemory* memory = guest_memory(handle);
+    return memory ? static_cast<long long>(memory->read64(static_cast<uint64_t>(addr), port)) : 0;
+}
+
+void guest_mem_write(long long handle, int port, long long addr, long long data, int bytes) {
+    GuestMemory* memory = guest_memory(handle);
+    if (memory) memory->write(static_cast<uint64_t>(addr), static_cast<uint64_t>(data), static_cast<unsigned>(bytes), port);
+}
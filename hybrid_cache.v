@@ -0,0 +1,200 @@
+// FAST L1 CACHE MODEL
+// Set-associative tag store with two lookup ports and one refill engine.
+// Tags only: data always comes from the backing memory (kept current by
+// write-through stores), so the cache changes timing but never values.
+// A lookup that misses starts a line refill; after MISS_LATENCY cycles of
+// backing memory latency the line is installed and the retried lookup hits.
+
+`include "mem_constants.vh"
+
+module hybrid_cache #(
+    parameter SIZE_BYTES = `L1_DEFAULT_SIZE,
+    parameter WAYS = `L1_DEFAULT_WAYS,
+    parameter LINE_BYTES = `L1_DEFAULT_LINE,
+    parameter REPLACEMENT = `CACHE_REPL_LRU,
+    parameter MISS_LATENCY = `MEM_DEFAULT_MISS_LATENCY,
+    parameter ADDR_BITS = 64            // Guest address width
+) (
+    input clk,
+    input rst,
+
+    // Lookup ports: req starts a refill on a miss, commit marks the access as
+    // performed this cycle (a hit is counted once, when it commits)
+    input [1:0] req,
+    input [1:0] commit,
+    input [ADDR_BITS-1:0] addr0,
+    input [ADDR_BITS-1:0] addr1,
+    output reg [1:0] hit,
+
+    // Statistics (misses = line refills, including wrong-path fetches)
+    output reg [63:0] hits /*verilator public_flat_rw*/,
+    output reg [63:0] misses /*verilator public_flat_rw*/,
+    output reg [63:0] evictions /*verilator public_flat_rw*/
+);
+
+    localparam LINES = SIZE_BYTES / LINE_BYTES;
+    localparam SETS = LINES / WAYS;
+    localparam OFFSET_BITS = $clog2(LINE_BYTES);
+    localparam LINE_BITS = ADDR_BITS - OFFSET_BITS;  // Whole line address is the tag
+    localparam WAY_BITS = WAYS > 1 ? $clog2(WAYS) : 1;
+
+    // === TAG STORE (entry = set * WAYS + way) ===
+    // The host time warp (time_warp.h) translates tags and steps the LFSR
+    reg valid [0:LINES-1] /*verilator public_flat*/;
+    reg [LINE_BITS-1:0] tags [0:LINES-1] /*verilator public_flat_rw*/;
+    reg [WAY_BITS-1:0] age [0:LINES-1];   // LRU rank, 0 = most recently used
+    reg [WAY_BITS-1:0] fifo_next [0:SETS-1];
+    reg [15:0] lfsr /*verilator public_flat_rw*/;
+
+    // === LOOKUP ===
+    wire [LINE_BITS-1:0] line0 = addr0[ADDR_BITS-1:OFFSET_BITS];
+    wire [LINE_BITS-1:0] line1 = addr1[ADDR_BITS-1:OFFSET_BITS];
+    wire [31:0] set0 = line0 % SETS;
+    wire [31:0] set1 = line1 % SETS;
+    reg [WAY_BITS-1:0] hit_way0, hit_way1;
+
+    always @(*) begin
+        hit = 2'b00;
+        hit_way0 = 0;
+        hit_way1 = 0;
+        for (integer w = 0; w < WAYS; w = w + 1) begin
+            if (valid[set0 * WAYS + w] && tags[set0 * WAYS + w] == line0) begin
+                hit[0] = 1;
+                hit_way0 = w[WAY_BITS-1:0];
+            end
+            if (valid[set1 * WAYS + w] && tags[set1 * WAYS + w] == line1) begin
+                hit[1] = 1;
+                hit_way1 = w[WAY_BITS-1:0];
+            end
+        end
+    end
+
+    // A port that waited on a refill counts that access as the miss, not a hit
+    reg [1:0] waited /*verilator public_flat*/;
+    reg [LINE_BITS-1:0] waited_line0 /*verilator public_flat_rw*/, waited_line1 /*verilator public_flat_rw*/;
+    wire count_hit0 = commit[0] && hit[0] && !(waited[0] && waited_line0 == line0);
+    wire count_hit1 = commit[1] && hit[1] && !(waited[1] && waited_line1 == line1);
+
+    // === REFILL ENGINE ===
+    reg fill_busy /*verilator public_flat*/;
+    reg fill_last_port;
+    reg [15:0] fill_count /*verilator public_flat*/;
+    reg [LINE_BITS-1:0] fill_line /*verilator public_flat_rw*/;
+
+    wire [1:0] miss = req & ~hit;
+    wire fill_pick1 = miss[1] && (!miss[0] || !fill_last_port); // Round-robin between ports
+    wire [31:0] fill_set = fill_line % SETS;
+
+    reg [WAY_BITS-1:0] victim;
+    always @(*) begin
+        case (REPLACEMENT)
+            `CACHE_REPL_FIFO: victim = fifo_next[fill_set];
+            `CACHE_REPL_RANDOM: victim = lfsr % WAYS;
+            default: begin // LRU: the way with the oldest rank
+                victim = 0;
+                for (integer w = 0; w < WAYS; w = w + 1) begin
+                    if (age[fill_set * WAYS + w] == WAYS - 1) victim = w[WAY_BITS-1:0];
+                end
+            end
+        endcase
+        // Empty ways fill first, lowest way first
+        for (integer w = WAYS - 1; w >= 0; w = w - 1) begin
+            if (!valid[fill_set * WAYS + w]) victim = w[WAY_BITS-1:0];
+        end
+    end
+
+    initial begin
+        invalidate_all();
+    end
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            invalidate_all();
+        end else begin
+            lfsr <= {lfsr[14:0], lfsr[15] ^ lfsr[13] ^ lfsr[12] ^ lfsr[10]};
+            hits <= hits + {63'h0, count_hit0} + {63'h0, count_hit1};
+
+            if (miss[0]) begin
+                waited[0] <= 1;
+                waited_line0 <= line0;
+            end else if (commit[0]) begin
+                waited[0] <= 0;
+            end
+            if (miss[1]) begin
+                waited[1] <= 1;
+                waited_line1 <= line1;
+            end else if (commit[1]) begin
+                waited[1] <= 0;
+            end
+
+            if (!fill_busy) begin
+                if (miss != 2'b00) begin
+                    fill_busy <= 1;
+                    fill_last_port <= fill_pick1;
+                    fill_line <= fill_pick1 ? line1 : line0;
+                    fill_count <= MISS_LATENCY;
+                    misses <= misses + 1;
+                end
+                touch_on_hit();
+            end else if (fill_count != 0) begin
+                fill_count <= fill_count - 1;
+                touch_on_hit();
+            end else begin
+                install_line();
+                fill_busy <= 0;
+            end
+        end
+    end
+
+    // === REPLACEMENT STATE ===
+    task invalidate_all;
+        begin
+            for (integer i = 0; i < LINES; i = i + 1) begin
+                valid[i] <= 0;
+                age[i] <= i % WAYS;
+            end
+            for (integer s = 0; s < SETS; s = s + 1) begin
+                fifo_next[s] <= 0;
+            end
+            lfsr <= 16'hACE1;
+            fill_busy <= 0;
+            fill_last_port <= 0;
+            waited <= 2'b00;
+            hits <= 0;
+            misses <= 0;
+            evictions <= 0;
+        end
+    endtask
+
+    // One LRU update per cycle: a fill, else port 0's hit, else port 1's
+    task touch_on_hit;
+        begin
+            if (commit[0] && hit[0]) touch(set0, hit_way0);
+            else if (commit[1] && hit[1]) touch(set1, hit_way1);
+        end
+    endtask
+
+    task touch;
+        input [31:0] set;
+        input [WAY_BITS-1:0] way;
+        begin
+            for (integer w = 0; w < WAYS; w = w + 1) begin
+                if (age[set * WAYS + w] < age[set * WAYS + way]) age[set * WAYS + w] <= age[set * WAYS + w] + 1;
+            end
+            age[set * WAYS + way] <= 0;
+        end
+    endtask
+
+    task install_line;
+        begin
+            if (valid[fill_set * WAYS + victim]) begin
+                evictions <= evictions + 1;
+                if (victim == fifo_next[fill_set]) fifo_next[fill_set] <= victim == WAYS - 1 ? 0 : victim + 1;
+            end
+            valid[fill_set * WAYS + victim] <= 1;
+            tags[fill_set * WAYS + victim] <= fill_line;
+            touch(fill_set, victim);
+        end
+    endtask
+
+endmodule
@@ -0,0 +1,184 @@
+// FAST SHARED MEMORY + ARBITER
+// Connects both cores to the backing memory, behind two L1 caches. Both fetch
+// ports share one L1I, so code of one ISA evicts the other's; the single data
+// port goes through the L1D and is granted round-robin when both cores request
+// it in the same cycle. Stores write through without allocating. A port's
+// ready/gnt stays low while its line is being refilled. The data port is
+// `VEC_VLEN bits wide so vector loads/stores move a whole register at once.
+//
+// The backing memory is one sparse 64-bit address space held by the harness
+// (guest_memory.h) and reached through DPI-C: code and data share it, and
+// nothing wraps. Data accesses to the console page (CONSOLE_BASE) go to the
+// UART instead and bypass the L1D.
+
+`include "mem_constants.vh"
+`include "simd_constants.vh"
+
+module hybrid_mem_arbiter #(
+    parameter L1I_SIZE = `L1_DEFAULT_SIZE,
+    parameter L1I_WAYS = `L1_DEFAULT_WAYS,
+    parameter L1I_LINE = `L1_DEFAULT_LINE,
+    parameter L1I_REPL = `CACHE_REPL_LRU,
+    parameter L1D_SIZE = `L1_DEFAULT_SIZE,
+    parameter L1D_WAYS = `L1_DEFAULT_WAYS,
+    parameter L1D_LINE = `L1_DEFAULT_LINE,
+    parameter L1D_REPL = `CACHE_REPL_LRU,
+    parameter MISS_LATENCY = `MEM_DEFAULT_MISS_LATENCY,
+    parameter CONSOLE_TX_CYCLES = `CONSOLE_DEFAULT_TX_CYCLES
+) (
+    input clk,
+    input rst,
+
+    // Instruction fetch, one port per core: data is valid when ready is high,
+    // commit says the core consumed it this cycle
+    input rv_fetch_req,
+    input rv_fetch_commit,
+    input [63:0] rv_fetch_addr,
+    output [31:0] rv_fetch_data,
+    output rv_fetch_ready,
+    input x86_fetch_req,
+    input x86_fetch_commit,
+    input [63:0] x86_fetch_addr,
+    output [31:0] x86_fetch_data,
+    output x86_fetch_ready,
+
+    // Shared data port: reads return 8 bytes (16 when bytes > 8), writes store
+    // `bytes` bytes, 1..16 (little-endian)
+    input rv_data_req,
+    input rv_data_we,
+    input [4:0] rv_data_bytes,
+    input [63:0] rv_data_addr,
+    input [`VEC_VLEN-1:0] rv_data_wdata,
+    output rv_data_gnt,
+    input x86_data_req,
+    input x86_data_we,
+    input [4:0] x86_data_bytes,
+    input [63:0] x86_data_addr,
+    input [`VEC_VLEN-1:0] x86_data_wdata,
+    output x86_data_gnt,
+    output [`VEC_VLEN-1:0] data_rdata,
+
+    // Cache statistics
+    output [63:0] l1i_hits,
+    output [63:0] l1i_misses,
+    output [63:0] l1i_evictions,
+    output [63:0] l1d_hits,
+    output [63:0] l1d_misses,
+    output [63:0] l1d_evictions,
+
+    // Console statistics
+    output [63:0] console_tx_bytes,
+    output [63:0] console_overruns
+);
+
+    // === BACKING MEMORY (sparse paged store in the harness, via DPI-C) ===
+    // Reads are combinational. They take mem_epoch, which every store bumps,
+    // so a read of an unchanged address still re-evaluates after a write.
+    import "DPI-C" function int guest_mem_fetch(input longint handle, input int port,
+                                                input longint addr, input int epoch);
+    import "DPI-C" function longint guest_mem_read64(input longint handle, input int port,
+                                                     input longint addr, input int epoch);
+    import "DPI-C" function void guest_mem_write(input longint handle, input int port,
+                                                 input longint addr, input longint data, input int bytes);
+
+    reg [63:0] mem_handle /*verilator public_flat_rw*/; // GuestMemory*, set by attach_memory()
+    reg [31:0] mem_epoch;
+
+    // Fetches read the aligned word holding the PC/RIP
+    assign rv_fetch_data = guest_mem_fetch(mem_handle, `MEM_PORT_RV_FETCH, {rv_fetch_addr[63:2], 2'b00}, mem_epoch);
+    assign x86_fetch_data = guest_mem_fetch(mem_handle, `MEM_PORT_X86_FETCH, {x86_fetch_addr[63:2], 2'b00}, mem_epoch);
+
+    // === L1 INSTRUCTION CACHE (port 0 = RISC-V, port 1 = x86) ===
+    wire [1:0] l1i_hit;
+    assign rv_fetch_ready = l1i_hit[0];
+    assign x86_fetch_ready = l1i_hit[1];
+
+    hybrid_cache #(.SIZE_BYTES(L1I_SIZE), .WAYS(L1I_WAYS), .LINE_BYTES(L1I_LINE),
+                   .REPLACEMENT(L1I_REPL), .MISS_LATENCY(MISS_LATENCY)) l1i (
+        .clk(clk), .rst(rst),
+        .req({x86_fetch_req, rv_fetch_req}), .commit({x86_fetch_commit, rv_fetch_commit}),
+        .addr0(rv_fetch_addr), .addr1(x86_fetch_addr), .hit(l1i_hit),
+        .hits(l1i_hits), .misses(l1i_misses), .evictions(l1i_evictions)
+    );
+
+    // === DATA PORT ARBITRATION ===
+    reg last_grant_x86;
+
+    wire x86_sel = x86_data_req && (!rv_data_req || !last_grant_x86);
+    wire rv_sel = rv_data_req && !x86_sel;
+
+    wire data_we = x86_sel ? x86_data_we : rv_data_we;
+    wire [4:0] data_bytes = x86_sel ? x86_data_bytes : rv_data_bytes;
+    wire [63:0] data_addr = x86_sel ? x86_data_addr : rv_data_addr;
+    wire [`VEC_VLEN-1:0] data_wdata = x86_sel ? x86_data_wdata : rv_data_wdata;
+    wire data_wide = data_bytes > 8;  // Vector access: second 64-bit half
+
+    // === MMIO DECODE ===
+    wire data_mmio = (data_addr & ~64'hFFF) == `CONSOLE_BASE;
+    wire [63:0] uart_rdata;
+
+    hybrid_uart #(.TX_CYCLES(CONSOLE_TX_CYCLES)) uart (
+        .clk(clk), .rst(rst),
+        .write((rv_data_gnt || x86_data_gnt) && data_we && data_mmio),
+        .reg_offset(data_addr[2:0]), .wdata(data_wdata[7:0]), .rdata(uart_rdata),
+        .tx_bytes(console_tx_bytes), .tx_overruns(console_overruns)
+    );
+
+    // === L1 DATA CACHE (port 0 = first byte, port 1 = last byte of a read
+    // that straddles two lines; MMIO is uncached) ===
+    wire data_load = (x86_sel || rv_sel) && !data_we && !data_mmio;
+    wire [63:0] data_span = data_wide ? `VEC_VLENB : 8;
+    wire data_straddles = (data_addr % L1D_LINE) + data_span > L1D_LINE;
+    wire [1:0] l1d_req = {data_load && data_straddles, data_load};
+    wire [1:0] l1d_hit;
+    wire data_ready = data_we || (l1d_hit | ~l1d_req) == 2'b11;
+
+    // Two ports only cover an access spanning at most two lines
+    generate
+        if (L1D_LINE < `VEC_VLENB) begin : l1d_line_check
+            $error("L1D_LINE (%0d) must be at least %0d bytes, the widest data access", L1D_LINE, `VEC_VLENB);
+        end
+    endgenerate
+
+    assign x86_data_gnt = x86_sel && data_ready;
+    assign rv_data_gnt = rv_sel && data_ready;
+
+    hybrid_cache #(.SIZE_BYTES(L1D_SIZE), .WAYS(L1D_WAYS), .LINE_BYTES(L1D_LINE),
+                   .REPLACEMENT(L1D_REPL), .MISS_LATENCY(MISS_LATENCY)) l1d (
+        .clk(clk), .rst(rst),
+        .req(l1d_req), .commit(l1d_req & {2{data_ready}}),
+        .addr0(data_addr), .addr1(data_addr + data_span - 64'd1), .hit(l1d_hit),
+        .hits(l1d_hits), .misses(l1d_misses), .evictions(l1d_evictions)
+    );
+
+    // The upper half is only read for wide accesses (one DPI call per half)
+    wire [63:0] data_rdata_hi = (data_wide && !data_mmio)
+                              ? guest_mem_read64(mem_handle, `MEM_PORT_DATA, data_addr + 64'd8, mem_epoch) : 64'h0;
+    assign data_rdata = {data_rdata_hi,
+                         data_mmio ? uart_rdata : guest_mem_read64(mem_handle, `MEM_PORT_DATA, data_addr, mem_epoch)};
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            last_grant_x86 <= 0;
+        end else if (rv_data_gnt || x86_data_gnt) begin
+            last_grant_x86 <= x86_data_gnt;
+            if (data_we && !data_mmio) begin
+                guest_mem_write(mem_handle, `MEM_PORT_DATA, data_addr, data_wdata[63:0],
+                                {27'h0, data_wide ? 5'd8 : data_bytes});
+                if (data_wide)
+                    guest_mem_write(mem_handle, `MEM_PORT_DATA, data_addr + 64'd8, data_wdata[127:64],
+                                    {27'h0, data_bytes - 5'd8});
+                mem_epoch <= mem_epoch + 1;
+            end
+        end
+    end
+
+    // The memory survives reset; the demo program now comes from the loader
+    // (load_builtin_program in program_loader.h)
+    initial begin
+        last_grant_x86 = 0;
+        mem_handle = 0;
+        mem_epoch = 0;
+    end
+
+endmodule
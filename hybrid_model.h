@@ -0,0 +1,273 @@
+// FAST Hybrid CPU - shared harness helpers
+// Reset, clocking and state capture used by every C++ driver of VRV64GC_optimized
+
+#pragma once
+
+#include "VRV64GC_optimized.h"
+#include "VRV64GC_optimized___024root.h"
+#include "verilated.h"
+#include "guest_memory.h"
+#include "guest_console.h"
+#include <cstdint>
+
+// SIMD units (mirror simd_constants.vh)
+static const int VEC_VLENB = 16;  // Bytes per vector / xmm register
+static const int VEC_LANES = 4;   // 32-bit lanes of the utilization counters
+static const int X86_XMM_REGS = 8;
+
+// Architectural state, read through the /*verilator public*/ arrays in the RTL
+struct CpuState {
+    uint64_t pc;
+    uint64_t x86_rip;
+    bool x86_mode;   // x86 core enabled
+    bool rv_active;  // RISC-V core enabled (both are in concurrent mode)
+    bool rv_idle;    // Parked in WFI (until reset)
+    bool x86_idle;   // Parked in HLT (until the next 0xDEADBEEF)
+    uint64_t regs[32];
+    uint64_t x86_regs[16];
+    uint64_t vregs[32][2];  // Vector registers, low half first
+    uint64_t vl;
+    uint64_t vsew;          // log2 of the element bytes
+    uint64_t xmm[X86_XMM_REGS][2];
+};
+
+// Opcode classes of perf_class_retired (mirror the PERF_CLASS_* defines)
+enum PerfClass {
+    PERF_CLASS_RV_ALU_IMM = 0,
+    PERF_CLASS_RV_ALU_REG = 1,
+    PERF_CLASS_RV_MULDIV = 2,
+    PERF_CLASS_RV_SYSTEM = 3,  // 0xDEADBEEF hand-off and WFI
+    PERF_CLASS_RV_BRANCH = 4,
+    PERF_CLASS_RV_JUMP = 5,
+    PERF_CLASS_RV_LOAD = 6,
+    PERF_CLASS_RV_STORE = 7,
+    PERF_CLASS_X86_ALU = 8,
+    PERF_CLASS_X86_NOP = 9,
+    PERF_CLASS_X86_IO = 10,
+    PERF_CLASS_X86_SIMD = 11,
+    PERF_CLASS_X86_HALT = 12,
+    PERF_CLASS_COUNT = 16
+};
+
+inline const char* perf_class_name(int perf_class) {
+    switch (perf_class) {
+        case PERF_CLASS_RV_ALU_IMM: return "rv_alu_imm";
+        case PERF_CLASS_RV_ALU_REG: return "rv_alu_reg";
+        case PERF_CLASS_RV_MULDIV: return "rv_muldiv";
+        case PERF_CLASS_RV_SYSTEM: return "rv_system";
+        case PERF_CLASS_RV_BRANCH: return "rv_branch";
+        case PERF_CLASS_RV_JUMP: return "rv_jump";
+        case PERF_CLASS_RV_LOAD: return "rv_load";
+        case PERF_CLASS_RV_STORE: return "rv_store";
+        case PERF_CLASS_X86_ALU: return "x86_alu";
+        case PERF_CLASS_X86_NOP: return "x86_nop";
+        case PERF_CLASS_X86_IO: return "x86_io";
+        case PERF_CLASS_X86_SIMD: return "x86_simd";
+        case PERF_CLASS_X86_HALT: return "x86_halt";
+        default: return nullptr;
+    }
+}
+
+// RISC-V branch predictor the model was built with (RV_BP_SCHEME, BP_* in rv_constants.vh)
+inline const char* bp_scheme_name(unsigned scheme) {
+    switch (scheme) {
+        case 0: return "static";
+        case 1: return "bimodal";
+        case 2: return "gshare";
+        default: return "unknown";
+    }
+}
+
+// Hardware performance counters from the RTL counter block
+struct PerfCounters {
+    uint64_t mcycle;
+    uint64_t minstret;
+    uint64_t rv_mcycle;
+    uint64_t rv_minstret;
+    uint64_t x86_mcycle;
+    uint64_t x86_minstret;
+    uint64_t mode_switches;    // 0xDEADBEEF hand-offs only
+    uint64_t unknown_skips;
+    uint64_t rv_idle_cycles;   // Cycles parked in WFI
+    uint64_t x86_idle_cycles;  // Cycles parked in HLT
+    uint64_t class_retired[PERF_CLASS_COUNT];
+    // RISC-V pipeline
+    uint64_t rv_stall_cycles;  // Load-use and data-port stalls
+    uint64_t rv_flushes;       // Redirects (mispredicts, JALR, handoff and WFI squash)
+    uint64_t rv_branches;      // Conditional branches resolved
+    uint64_t rv_mispredicts;   // ... with the wrong predicted direction
+    // L1 caches (misses = line refills from the backing memory)
+    uint64_t l1i_hits;
+    uint64_t l1i_misses;
+    uint64_t l1i_evictions;
+    uint64_t l1d_hits;
+    uint64_t l1d_misses;
+    uint64_t l1d_evictions;
+    // Console UART
+    uint64_t console_tx_bytes;  // Bytes drained to the host
+    uint64_t console_overruns;  // Writes dropped on a full TX FIFO
+    // SIMD units
+    uint64_t rv_simd_ops;       // Vector arithmetic/load/store instructions retired
+    uint64_t rv_simd_elements;  // Elements they processed
+    uint64_t x86_simd_ops;      // SSE instructions retired
+    uint64_t x86_simd_elements; // (MOVDQU counts bytes)
+    uint64_t simd_lane_active[VEC_LANES]; // Both cores: SIMD instructions that used each lane
+};
+
+// Public RTL state. The cores and the memory arbiter are single-instance
+// modules that Verilator inlines, so their /*verilator public_flat*/ signals
+// live in the root under their hierarchical names.
+inline auto& rtl_regs(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__rv_core__DOT__regs; }
+inline auto& rtl_x86_regs(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__x86_core__DOT__x86_regs; }
+inline auto& rtl_mem_handle(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__mem__DOT__mem_handle; }
+inline auto& rtl_console_handle(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__mem__DOT__uart__DOT__console_handle; }
+inline auto& rtl_vregs(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__rv_core__DOT__vregs; }
+inline auto& rtl_vl(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__rv_core__DOT__vl; }
+inline auto& rtl_vsew(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__rv_core__DOT__vsew; }
+inline auto& rtl_xmm(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__x86_core__DOT__xmm; }
+inline auto& rtl_rv_idle(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__rv_core__DOT__idle; }
+inline auto& rtl_x86_idle(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__x86_core__DOT__idle; }
+
+// 128-bit RTL registers are four 32-bit words, least significant first
+template <typename Wide>
+inline void wide_to_u64(const Wide& wide, uint64_t out[2]) {
+    out[0] = static_cast<uint64_t>(wide[0]) | static_cast<uint64_t>(wide[1]) << 32;
+    out[1] = static_cast<uint64_t>(wide[2]) | static_cast<uint64_t>(wide[3]) << 32;
+}
+
+template <typename Wide>
+inline void u64_to_wide(const uint64_t in[2], Wide& wide) {
+    wide[0] = static_cast<uint32_t>(in[0]);
+    wide[1] = static_cast<uint32_t>(in[0] >> 32);
+    wide[2] = static_cast<uint32_t>(in[1]);
+    wide[3] = static_cast<uint32_t>(in[1] >> 32);
+}
+
+// Back the model's memory with `memory` (owned by the caller, must outlive the
+// model). Evaluates first so the initial blocks cannot clear the handle.
+inline void attach_memory(VRV64GC_optimized* cpu, GuestMemory* memory) {
+    cpu->eval();
+    rtl_mem_handle(cpu) = reinterpret_cast<uintptr_t>(memory);
+}
+
+inline GuestMemory* attached_memory(VRV64GC_optimized* cpu) {
+    return reinterpret_cast<GuestMemory*>(static_cast<uintptr_t>(rtl_mem_handle(cpu)));
+}
+
+// Send the console UART's output to `console` (same lifetime rules as memory;
+// without one the output is dropped)
+inline void attach_console(VRV64GC_optimized* cpu, GuestConsole* console) {
+    cpu->eval();
+    rtl_console_handle(cpu) = reinterpret_cast<uintptr_t>(console);
+}
+
+inline GuestConsole* attached_console(VRV64GC_optimized* cpu) {
+    return reinterpret_cast<GuestConsole*>(static_cast<uintptr_t>(rtl_console_handle(cpu)));
+}
+
+// Hold reset for one full clock cycle, then release it
+inline void reset_cpu(VRV64GC_optimized* cpu) {
+    cpu->rst = 1;
+    cpu->clk = 0;
+    cpu->eval();
+    cpu->clk = 1;
+    cpu->eval();
+    cpu->clk = 0;
+    cpu->eval();
+    cpu->rst = 0;
+    cpu->eval();
+}
+
+// One full clock cycle (posedge + negedge)
+inline void tick(VRV64GC_optimized* cpu) {
+    cpu->clk = 1;
+    cpu->eval();
+    cpu->clk = 0;
+    cpu->eval();
+}
+
+inline void run_cycles(VRV64GC_optimized* cpu, uint64_t cycles) {
+    for (uint64_t i = 0; i < cycles; i++) {
+        tick(cpu);
+    }
+}
+
+// Run both cores every cycle from the next reset (false = one core at a time,
+// handing off on 0xDEADBEEF). Evaluates first so initial blocks cannot undo it.
+inline void set_concurrent(VRV64GC_optimized* cpu, bool concurrent) {
+    cpu->eval();
+    cpu->rootp->RV64GC_optimized__DOT__boot_concurrent = concurrent;
+}
+
+inline CpuState capture_state(VRV64GC_optimized* cpu) {
+    CpuState state;
+    auto* root = cpu->rootp;
+    state.pc = cpu->pc;
+    state.x86_rip = cpu->x86_rip;
+    state.x86_mode = root->RV64GC_optimized__DOT__x86_mode_active;
+    state.rv_active = root->RV64GC_optimized__DOT__rv_mode_active;
+    state.rv_idle = cpu->rv_idle;
+    state.x86_idle = cpu->x86_idle;
+    for (int i = 0; i < 32; i++) state.regs[i] = rtl_regs(cpu)[i];
+    for (int i = 0; i < 16; i++) state.x86_regs[i] = rtl_x86_regs(cpu)[i];
+    for (int i = 0; i < 32; i++) wide_to_u64(rtl_vregs(cpu)[i], state.vregs[i]);
+    state.vl = rtl_vl(cpu);
+    state.vsew = rtl_vsew(cpu);
+    for (int i = 0; i < X86_XMM_REGS; i++) wide_to_u64(rtl_xmm(cpu)[i], state.xmm[i]);
+    return state;
+}
+
+inline PerfCounters capture_counters(VRV64GC_optimized* cpu) {
+    PerfCounters perf;
+    perf.mcycle = cpu->mcycle;
+    perf.minstret = cpu->minstret;
+    perf.rv_mcycle = cpu->rv_mcycle;
+    perf.rv_minstret = cpu->rv_minstret;
+    perf.x86_mcycle = cpu->x86_mcycle;
+    perf.x86_minstret = cpu->x86_minstret;
+    perf.mode_switches = cpu->perf_mode_switches;
+    perf.unknown_skips = cpu->perf_unknown_skips;
+    perf.rv_idle_cycles = cpu->rv_idle_cycles;
+    perf.x86_idle_cycles = cpu->x86_idle_cycles;
+    perf.rv_stall_cycles = cpu->rv_stall_cycles;
+    perf.rv_flushes = cpu->rv_flushes;
+    perf.rv_branches = cpu->rv_branches;
+    perf.rv_mispredicts = cpu->rv_mispredicts;
+    perf.l1i_hits = cpu->l1i_hits;
+    perf.l1i_misses = cpu->l1i_misses;
+    perf.l1i_evictions = cpu->l1i_evictions;
+    perf.l1d_hits = cpu->l1d_hits;
+    perf.l1d_misses = cpu->l1d_misses;
+    perf.l1d_evictions = cpu->l1d_evictions;
+    perf.console_tx_bytes = cpu->console_tx_bytes;
+    perf.console_overruns = cpu->console_overruns;
+    perf.rv_simd_ops = cpu->rv_simd_ops;
+    perf.rv_simd_elements = cpu->rv_simd_elements;
+    perf.x86_simd_ops = cpu->x86_simd_ops;
+    perf.x86_simd_elements = cpu->x86_simd_elements;
+    for (int i = 0; i < VEC_LANES; i++) {
+        perf.simd_lane_active[i] = cpu->rootp->RV64GC_optimized__DOT__rv_core__DOT__simd_lane_active[i] +
+                                   cpu->rootp->RV64GC_optimized__DOT__x86_core__DOT__simd_lane_active[i];
+    }
+    // Each core counts its own eight classes; x86 classes start at 8
+    for (int i = 0; i < PERF_CLASS_COUNT / 2; i++) {
+        perf.class_retired[i] = cpu->rootp->RV64GC_optimized__DOT__rv_core__DOT__perf_class_retired[i];
+        perf.class_retired[i + PERF_CLASS_COUNT / 2] =
+            cpu->rootp->RV64GC_optimized__DOT__x86_core__DOT__perf_class_retired[i];
+    }
+    return perf;
+}
+
+inline double ratio(uint64_t num, uint64_t den) {
+    return den ? static_cast<double>(num) / den : 0.0;
+}
+
+// Share of retired SIMD instructions that used `lane`, in percent
+inline double lane_utilization(const PerfCounters& perf, int lane) {
+    return ratio(perf.simd_lane_active[lane], perf.rv_simd_ops + perf.x86_simd_ops) * 100.0;
+}
+
+// Share of cache accesses that hit, in percent
+inline double hit_rate(uint64_t hits, uint64_t misses) {
+    return ratio(hits, hits + misses) * 100.0;
+}
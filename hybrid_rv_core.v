@@ -0,0 +1,879 @@
+// FAST RISC-V CORE
+// RV64I + MUL in a five-stage pipeline (IF/ID/EX/MEM/WB) with its own fetch
+// port and a load/store port into the shared memory arbiter, plus a small V
+// subset (vsetvli, vadd/vmul .vv/.vx, unit-stride vle/vse) on 32 x `VEC_VLEN-bit
+// vector registers, executed in EX by the shared SIMD ALU (hybrid_simd_alu.v).
+//  - EX takes operands forwarded from MEM and WB, and WB bypasses the register
+//    file read in ID, so only a load followed by a dependent instruction stalls.
+//    Vector registers and vl/vsew are forwarded the same way.
+//  - Vector ops are LMUL = 1 and unmasked, with tail elements undisturbed; a
+//    vle/vse moves the whole active part of a register in one data access.
+//  - Branches and JAL are predicted in IF (BP_SCHEME picks the predictor) and
+//    resolved in EX; a wrong guess or a JALR redirect flushes IF/ID and ID/EX.
+//  - 0xDEADBEEF commits in WB and asks the top level to start the x86 core at
+//    pc+4. In handoff mode everything younger is squashed before it can store.
+//  - WFI commits in WB, squashes everything younger and parks the core (idle)
+//    with pc at the next instruction. There are no interrupt sources, so only
+//    reset wakes it; a parked core only counts mcycle and idle_cycles.
+// pc is the architectural PC (next instruction to commit), not the fetch PC.
+// A fetch that misses the L1I inserts bubbles until the line arrives; a load
+// that misses the L1D freezes IF..MEM like any other data-port stall.
+
+`include "rv_constants.vh"
+`include "simd_constants.vh"
+
+module hybrid_rv_core #(
+    parameter BP_SCHEME = `BP_GSHARE,  // `BP_STATIC, `BP_BIMODAL or `BP_GSHARE
+    parameter BP_INDEX_BITS = 7        // 2^BP_INDEX_BITS counters; also the gshare history length
+) (
+    input clk,
+    input rst,
+    input run,                      // Core advances this cycle
+    input handoff,                  // 0xDEADBEEF parks this core (squash younger instructions)
+    input [63:0] boot_pc,
+
+    // Instruction fetch (memory arbiter port, through the shared L1I)
+    output fetch_req,
+    output fetch_commit,            // The fetched word enters IF/ID this cycle
+    output [63:0] fetch_addr,
+    input [31:0] fetch_data,
+    input fetch_ready,              // L1I hit: fetch_data is valid
+
+    // Data port (memory arbiter + L1D), driven by the load/store in MEM
+    output data_req,
+    output data_we,
+    output [4:0] data_bytes,        // Access width in bytes (1..`VEC_VLENB)
+    output [63:0] data_addr,
+    output [`VEC_VLEN-1:0] data_wdata,
+    input data_gnt,
+    input [`VEC_VLEN-1:0] data_rdata,
+
+    // x86 start request, raised while 0xDEADBEEF is in WB
+    output start_x86,
+    output [63:0] start_x86_rip,
+
+    // Architectural / debug outputs (debug_* describe the last instruction through WB)
+    output reg [63:0] pc /*verilator public_flat_rw*/,
+    output reg [63:0] reg_out,
+    output reg [31:0] debug_instr,
+    output reg [6:0] debug_opcode,
+    output reg [4:0] debug_rd,
+    output reg [4:0] debug_rs1,
+    output reg [63:0] debug_imm,
+    output reg [63:0] debug_alu_result,
+    output reg idle /*verilator public_flat_rw*/, // Parked by WFI until reset
+
+    // Performance counters (cycles this core ran, instructions it retired)
+    output reg [63:0] mcycle /*verilator public_flat_rw*/,
+    output reg [63:0] minstret /*verilator public_flat_rw*/,
+    output reg [63:0] mode_switches,
+    output reg [63:0] unknown_skips /*verilator public_flat_rw*/,
+    output reg [63:0] idle_cycles /*verilator public_flat_rw*/, // Cycles spent parked in WFI
+
+    // Pipeline counters
+    output reg [63:0] stall_cycles, // Load-use and data-port (L1D miss) stall cycles
+    output reg [63:0] flushes,      // Redirects that squashed younger instructions
+    output reg [63:0] branches,     // Conditional branches resolved in EX
+    output reg [63:0] mispredicts,  // ... whose predicted direction was wrong
+
+    // Vector counters (see simd_retire)
+    output reg [63:0] simd_ops,     // Vector arithmetic/load/store instructions retired
+    output reg [63:0] simd_elements,// Elements they processed
+
+    // Retirement trace port
+    output reg retire_valid,
+    output reg [63:0] retire_pc /*verilator public_flat_rw*/,
+    output reg [31:0] retire_instr,
+    output reg retire_wen,
+    output reg [4:0] retire_rd,
+    output reg [63:0] retire_value
+);
+
+    localparam BP_ENTRIES = 1 << BP_INDEX_BITS;
+
+    // === REGISTER FILES ===
+    reg [63:0] regs [0:31] /*verilator public_flat_rw*/;  // Integer registers
+    reg [63:0] fregs [0:31];                            // Floating-point registers (unused)
+    reg [`VEC_VLEN-1:0] vregs [0:31] /*verilator public_flat_rw*/; // Vector registers
+    reg [4:0] vl /*verilator public_flat_rw*/;          // Active elements (<= VLMAX)
+    reg [1:0] vsew /*verilator public_flat_rw*/;        // Element width (`VEC_SEW_*)
+
+    // Retired instructions per opcode class (PERF_CLASS_RV_*)
+    reg [63:0] perf_class_retired [0:7] /*verilator public_flat_rw*/;
+
+    // Retired vector instructions that used each `VEC_LANE_BITS lane
+    reg [63:0] simd_lane_active [0:`VEC_LANES-1] /*verilator public_flat*/;
+
+    // === BRANCH PREDICTOR ===
+    reg [1:0] bp_counters [0:BP_ENTRIES-1];  // 2-bit saturating, >= 2 predicts taken
+    reg [BP_INDEX_BITS-1:0] bp_history;      // Resolved directions, newest in bit 0
+
+    // === PIPELINE REGISTERS ===
+    // The host time warp (time_warp.h) reads the valid bits and moves fetch_pc
+    reg [63:0] fetch_pc /*verilator public_flat_rw*/;
+
+    reg if_id_valid /*verilator public_flat*/;
+    reg [63:0] if_id_pc;
+    reg [31:0] if_id_instr;
+    reg [63:0] if_id_pred_npc;
+    reg [BP_INDEX_BITS-1:0] if_id_bp_index;
+
+    reg id_ex_valid /*verilator public_flat*/;
+    reg [63:0] id_ex_pc;
+    reg [31:0] id_ex_instr;
+    reg [63:0] id_ex_pred_npc;
+    reg [BP_INDEX_BITS-1:0] id_ex_bp_index;
+    reg [63:0] id_ex_imm;
+    reg [63:0] id_ex_rs1_val, id_ex_rs2_val;
+    reg [3:0] id_ex_class;
+    reg id_ex_writes_rd, id_ex_unknown;
+    reg id_ex_vec, id_ex_writes_vd;
+    reg [`VEC_VLEN-1:0] id_ex_vs1_val, id_ex_vs2_val, id_ex_vd_val;
+
+    reg ex_mem_valid /*verilator public_flat*/;
+    reg [63:0] ex_mem_pc;
+    reg [31:0] ex_mem_instr;
+    reg [63:0] ex_mem_imm;
+    reg [63:0] ex_mem_result;   // ALU result, link address or load/store address
+    reg [63:0] ex_mem_store_data;
+    reg [63:0] ex_mem_npc;
+    reg [3:0] ex_mem_class;
+    reg ex_mem_writes_rd, ex_mem_unknown;
+    reg ex_mem_vec, ex_mem_writes_vd;
+    reg [`VEC_VLEN-1:0] ex_mem_vresult; // Vector result, old vd (vle) or store data (vse)
+    reg [`VEC_VLENB-1:0] ex_mem_vmask;  // Active bytes
+    reg [4:0] ex_mem_vbytes;            // vle/vse access width (0 = no access)
+    reg [4:0] ex_mem_velems;
+
+    reg mem_wb_valid /*verilator public_flat*/;
+    reg [63:0] mem_wb_pc;
+    reg [31:0] mem_wb_instr;
+    reg [63:0] mem_wb_imm;
+    reg [63:0] mem_wb_result;
+    reg [63:0] mem_wb_npc;
+    reg [3:0] mem_wb_class;
+    reg mem_wb_writes_rd, mem_wb_unknown;
+    reg mem_wb_vec, mem_wb_writes_vd;
+    reg [`VEC_VLEN-1:0] mem_wb_vresult;
+    reg [`VEC_VLENB-1:0] mem_wb_vmask;
+    reg [4:0] mem_wb_velems;
+
+    // === IF: FETCH + PREDICT ===
+    wire if_is_jal = fetch_data[6:0] == `RV_OP_JAL && fetch_data != `RV_MODE_SWITCH;
+    wire if_is_branch = fetch_data[6:0] == `RV_OP_BRANCH;
+    wire [BP_INDEX_BITS-1:0] if_bp_index = BP_SCHEME == `BP_GSHARE ? fetch_pc[BP_INDEX_BITS+1:2] ^ bp_history
+                                                                   : fetch_pc[BP_INDEX_BITS+1:2];
+    wire if_bp_taken = BP_SCHEME == `BP_STATIC ? fetch_data[31]  // Negative offset: loop back-edge
+                                               : bp_counters[if_bp_index][1];
+    wire [63:0] if_pred_npc = if_is_jal ? fetch_pc + imm_j(fetch_data)
+                            : (if_is_branch && if_bp_taken) ? fetch_pc + imm_b(fetch_data)
+                            : fetch_pc + 4;
+
+    assign fetch_addr = fetch_pc;
+
+    // === ID: DECODE + REGISTER READ ===
+    wire [4:0] id_rs1 = if_id_instr[19:15];
+    wire [4:0] id_rs2 = if_id_instr[24:20];
+    reg [63:0] id_imm;
+    reg [3:0] id_class;
+    reg id_writes_rd, id_uses_rs1, id_uses_rs2, id_unknown;
+    reg id_vec, id_writes_vd, id_uses_vs1, id_uses_vs2, id_uses_vd;
+
+    always @(*) begin
+        id_imm = imm_i(if_id_instr);
+        id_class = `PERF_CLASS_RV_ALU_IMM;
+        id_writes_rd = 1;
+        id_uses_rs1 = 1;
+        id_uses_rs2 = 0;
+        id_unknown = 0;
+        id_vec = 0;
+        id_writes_vd = 0;
+        id_uses_vs1 = 0;
+        id_uses_vs2 = 0;
+        id_uses_vd = 0;
+
+        if (if_id_instr == `RV_MODE_SWITCH) begin
+            id_class = `PERF_CLASS_RV_SYSTEM;
+            id_writes_rd = 0;
+            id_uses_rs1 = 0;
+        end else begin
+            case (if_id_instr[6:0])
+                `RV_OP_IMM: ;
+                `RV_OP_IMM_32: id_unknown = !is_word_funct3(if_id_instr[14:12]);
+                `RV_OP_OP: begin
+                    id_class = if_id_instr[31:25] == `RV_FUNCT7_MULDIV ? `PERF_CLASS_RV_MULDIV : `PERF_CLASS_RV_ALU_REG;
+                    id_uses_rs2 = 1;
+                    id_unknown = !is_reg_funct(if_id_instr[31:25], if_id_instr[14:12]);
+                end
+                `RV_OP_OP_32: begin
+                    id_class = if_id_instr[31:25] == `RV_FUNCT7_MULDIV ? `PERF_CLASS_RV_MULDIV : `PERF_CLASS_RV_ALU_REG;
+                    id_uses_rs2 = 1;
+                    id_unknown = !is_reg_funct(if_id_instr[31:25], if_id_instr[14:12]) ||
+                                 (if_id_instr[31:25] != `RV_FUNCT7_MULDIV && !is_word_funct3(if_id_instr[14:12]));
+                end
+                `RV_OP_LUI, `RV_OP_AUIPC: begin
+                    id_imm = imm_u(if_id_instr);
+                    id_uses_rs1 = 0;
+                end
+                `RV_OP_JAL: begin
+                    id_imm = imm_j(if_id_instr);
+                    id_class = `PERF_CLASS_RV_JUMP;
+                    id_uses_rs1 = 0;
+                end
+                `RV_OP_JALR: id_class = `PERF_CLASS_RV_JUMP;
+                `RV_OP_BRANCH: begin
+                    id_imm = imm_b(if_id_instr);
+                    id_class = `PERF_CLASS_RV_BRANCH;
+                    id_writes_rd = 0;
+                    id_uses_rs2 = 1;
+                    id_unknown = if_id_instr[14:13] == 2'b01; // funct3 2 and 3 are reserved
+                end
+                `RV_OP_LOAD: begin
+                    id_class = `PERF_CLASS_RV_LOAD;
+                    id_unknown = if_id_instr[14:12] == 3'b111;
+                end
+                `RV_OP_STORE: begin
+                    id_imm = imm_s(if_id_instr);
+                    id_class = `PERF_CLASS_RV_STORE;
+                    id_writes_rd = 0;
+                    id_uses_rs2 = 1;
+                    id_unknown = if_id_instr[14];
+                end
+                `RV_OP_V: begin
+                    if (if_id_instr[14:12] == `RV_FUNCT3_OPCFG) begin // vsetvli: rd = new vl
+                        id_uses_rs1 = if_id_instr[19:15] != 0;
+                        id_unknown = if_id_instr[31]; // vsetivli/vsetvl not implemented
+                    end else begin
+                        // vd = vs2 op (vs1 | x[rs1]); the old vd supplies the tail
+                        id_class = if_id_instr[31:26] == `RV_FUNCT6_VMUL ? `PERF_CLASS_RV_MULDIV : `PERF_CLASS_RV_ALU_REG;
+                        id_writes_rd = 0;
+                        id_vec = 1;
+                        id_writes_vd = 1;
+                        id_uses_rs1 = if_id_instr[14];
+                        id_uses_vs1 = !if_id_instr[14];
+                        id_uses_vs2 = 1;
+                        id_uses_vd = 1;
+                        id_unknown = !is_vector_arith(if_id_instr);
+                    end
+                end
+                `RV_OP_LOAD_FP: begin // vle<eew>.v vd, (rs1)
+                    id_imm = 0;
+                    id_class = `PERF_CLASS_RV_LOAD;
+                    id_writes_rd = 0;
+                    id_vec = 1;
+                    id_writes_vd = 1;
+                    id_uses_vd = 1;
+                    id_unknown = !is_vector_mem(if_id_instr); // Scalar FP loads are not implemented
+                end
+                `RV_OP_STORE_FP: begin // vse<eew>.v vs3, (rs1)
+                    id_imm = 0;
+                    id_class = `PERF_CLASS_RV_STORE;
+                    id_writes_rd = 0;
+                    id_vec = 1;
+                    id_uses_vd = 1;
+                    id_unknown = !is_vector_mem(if_id_instr);
+                end
+                `RV_OP_SYSTEM: begin // Only WFI; ecall/ebreak/CSRs are not implemented
+                    id_class = `PERF_CLASS_RV_SYSTEM;
+                    id_writes_rd = 0;
+                    id_uses_rs1 = 0;
+                    id_unknown = if_id_instr != `RV_WFI;
+                end
+                default: id_unknown = 1;
+            endcase
+        end
+
+        // Unknown words are skipped: they flow down the pipeline without effects
+        if (id_unknown) begin
+            id_writes_rd = 0;
+            id_uses_rs1 = 0;
+            id_uses_rs2 = 0;
+            id_vec = 0;
+            id_writes_vd = 0;
+            id_uses_vs1 = 0;
+            id_uses_vs2 = 0;
+            id_uses_vd = 0;
+        end
+        if (if_id_instr[11:7] == 0) id_writes_rd = 0; // x0 is hardwired to zero
+    end
+
+    // Register file read, bypassing the value WB writes this cycle
+    wire wb_writes = mem_wb_valid && mem_wb_writes_rd;
+    wire [4:0] wb_rd = mem_wb_instr[11:7];
+    wire [63:0] id_rs1_val = (wb_writes && wb_rd == id_rs1) ? mem_wb_result : regs[id_rs1];
+    wire [63:0] id_rs2_val = (wb_writes && wb_rd == id_rs2) ? mem_wb_result : regs[id_rs2];
+
+    wire [4:0] id_vd = if_id_instr[11:7];
+    wire wb_vwrites = mem_wb_valid && mem_wb_writes_vd;
+    wire [`VEC_VLEN-1:0] id_vs1_val = (wb_vwrites && wb_rd == id_rs1) ? mem_wb_vresult : vregs[id_rs1];
+    wire [`VEC_VLEN-1:0] id_vs2_val = (wb_vwrites && wb_rd == id_rs2) ? mem_wb_vresult : vregs[id_rs2];
+    wire [`VEC_VLEN-1:0] id_vd_val = (wb_vwrites && wb_rd == id_vd) ? mem_wb_vresult : vregs[id_vd];
+
+    // Load-use hazard: the loaded value is not available until the load leaves MEM
+    wire id_ex_is_load = if_id_valid && id_ex_valid && id_ex_class == `PERF_CLASS_RV_LOAD;
+    wire load_use = id_ex_is_load && (
+        (id_ex_writes_rd && ((id_uses_rs1 && id_ex_instr[11:7] == id_rs1) || (id_uses_rs2 && id_ex_instr[11:7] == id_rs2))) ||
+        (id_ex_writes_vd && ((id_uses_vs1 && id_ex_instr[11:7] == id_rs1) || (id_uses_vs2 && id_ex_instr[11:7] == id_rs2) ||
+                             (id_uses_vd && id_ex_instr[11:7] == id_vd))));
+
+    // === EX: FORWARD + EXECUTE + RESOLVE ===
+    wire [4:0] ex_rs1 = id_ex_instr[19:15];
+    wire [4:0] ex_rs2 = id_ex_instr[24:20];
+    wire mem_fwd_ok = ex_mem_valid && ex_mem_writes_rd && ex_mem_class != `PERF_CLASS_RV_LOAD;
+    wire [63:0] ex_a = (mem_fwd_ok && ex_mem_instr[11:7] == ex_rs1) ? ex_mem_result
+                     : (wb_writes && wb_rd == ex_rs1) ? mem_wb_result
+                     : id_ex_rs1_val;
+    wire [63:0] ex_b = (mem_fwd_ok && ex_mem_instr[11:7] == ex_rs2) ? ex_mem_result
+                     : (wb_writes && wb_rd == ex_rs2) ? mem_wb_result
+                     : id_ex_rs2_val;
+
+    wire [4:0] ex_vd = id_ex_instr[11:7];
+    wire mem_vfwd_ok = ex_mem_valid && ex_mem_writes_vd && ex_mem_class != `PERF_CLASS_RV_LOAD;
+    wire [`VEC_VLEN-1:0] ex_vs1 = (mem_vfwd_ok && ex_mem_instr[11:7] == ex_rs1) ? ex_mem_vresult
+                                : (wb_vwrites && wb_rd == ex_rs1) ? mem_wb_vresult
+                                : id_ex_vs1_val;
+    wire [`VEC_VLEN-1:0] ex_vs2 = (mem_vfwd_ok && ex_mem_instr[11:7] == ex_rs2) ? ex_mem_vresult
+                                : (wb_vwrites && wb_rd == ex_rs2) ? mem_wb_vresult
+                                : id_ex_vs2_val;
+    wire [`VEC_VLEN-1:0] ex_vd_old = (mem_vfwd_ok && ex_mem_instr[11:7] == ex_vd) ? ex_mem_vresult
+                                   : (wb_vwrites && wb_rd == ex_vd) ? mem_wb_vresult
+                                   : id_ex_vd_val;
+
+    // vl/vsew as of this instruction: a vsetvli in MEM or WB has not updated them yet
+    wire mem_is_vsetvli = ex_mem_valid && !ex_mem_unknown && is_vsetvli(ex_mem_instr);
+    wire wb_is_vsetvli = mem_wb_valid && !mem_wb_unknown && is_vsetvli(mem_wb_instr);
+    wire [4:0] ex_vl = mem_is_vsetvli ? ex_mem_result[4:0] : wb_is_vsetvli ? mem_wb_result[4:0] : vl;
+    wire [1:0] ex_vsew = mem_is_vsetvli ? ex_mem_instr[24:23] : wb_is_vsetvli ? mem_wb_instr[24:23] : vsew;
+
+    // vsetvli: vl = min(AVL, VLMAX); rs1 = x0 asks for VLMAX (rd != x0) or keeps vl.
+    // Only LMUL = 1 with SEW <= 64 is supported, anything else sets vl = 0.
+    wire [4:0] ex_vlmax = 5'd16 >> id_ex_instr[24:23];
+    wire ex_vill = id_ex_instr[22:20] != 0 || id_ex_instr[25] || id_ex_instr[30:28] != 0;
+    wire [4:0] ex_new_vl = ex_vill ? 5'd0
+                         : ex_rs1 != 0 ? (ex_a < {59'h0, ex_vlmax} ? ex_a[4:0] : ex_vlmax)
+                         : id_ex_instr[11:7] != 0 ? ex_vlmax
+                         : (ex_vl < ex_vlmax ? ex_vl : ex_vlmax);
+
+    // Vector arithmetic on the shared SIMD ALU; vle/vse use their own element width
+    wire ex_is_vmem = id_ex_instr[6:0] != `RV_OP_V;
+    wire [1:0] ex_eew = ex_is_vmem ? vec_sew_of_width(id_ex_instr[14:12]) : ex_vsew;
+    wire [4:0] ex_velems = ex_vl < (5'd16 >> ex_eew) ? ex_vl : (5'd16 >> ex_eew); // One register (LMUL = 1)
+    wire [`VEC_VLENB-1:0] ex_vmask = vec_byte_mask(ex_velems, ex_eew);
+    wire [`VEC_VLEN-1:0] ex_simd_result;
+
+    hybrid_simd_alu simd (
+        .op(id_ex_instr[31:26] == `RV_FUNCT6_VMUL ? `VEC_OP_MUL : `VEC_OP_ADD), .sew(ex_vsew),
+        .a(ex_vs2), .b(id_ex_instr[14] ? vec_splat(ex_a, ex_vsew) : ex_vs1), .result(ex_simd_result)
+    );
+
+    // vle carries the old vd (merged with the data in MEM), vse its store data
+    wire [`VEC_VLEN-1:0] ex_vresult = ex_is_vmem ? ex_vd_old : vec_merge(ex_simd_result, ex_vd_old, ex_vmask);
+
+    wire ex_is_reg = id_ex_instr[6:0] == `RV_OP_OP || id_ex_instr[6:0] == `RV_OP_OP_32;
+    wire ex_is_mul = ex_is_reg && id_ex_instr[31:25] == `RV_FUNCT7_MULDIV;
+    wire ex_is_branch = !id_ex_unknown && id_ex_class == `PERF_CLASS_RV_BRANCH;
+    reg [63:0] ex_result;
+    reg [63:0] ex_npc;
+    reg ex_taken;
+
+    always @(*) begin
+        case (id_ex_instr[6:0])
+            `RV_OP_IMM, `RV_OP_OP:
+                ex_result = alu64(id_ex_instr[14:12], ex_is_reg && id_ex_instr[30], id_ex_instr[30], ex_is_mul,
+                                  ex_a, ex_is_reg ? ex_b : id_ex_imm);
+            `RV_OP_IMM_32, `RV_OP_OP_32:
+                ex_result = alu32(id_ex_instr[14:12], ex_is_reg && id_ex_instr[30], id_ex_instr[30], ex_is_mul,
+                                  ex_a, ex_is_reg ? ex_b : id_ex_imm);
+            `RV_OP_LUI: ex_result = id_ex_imm;
+            `RV_OP_AUIPC: ex_result = id_ex_pc + id_ex_imm;
+            `RV_OP_JAL, `RV_OP_JALR: ex_result = id_ex_pc + 4;
+            `RV_OP_V: ex_result = {59'h0, ex_new_vl}; // vsetvli (vector arithmetic has no scalar result)
+            default: ex_result = ex_a + id_ex_imm; // Load/store effective address
+        endcase
+
+        case (id_ex_instr[14:12])
+            `RV_FUNCT3_BEQ: ex_taken = ex_a == ex_b;
+            `RV_FUNCT3_BNE: ex_taken = ex_a != ex_b;
+            `RV_FUNCT3_BLT: ex_taken = $signed(ex_a) < $signed(ex_b);
+            `RV_FUNCT3_BGE: ex_taken = $signed(ex_a) >= $signed(ex_b);
+            `RV_FUNCT3_BLTU: ex_taken = ex_a < ex_b;
+            `RV_FUNCT3_BGEU: ex_taken = ex_a >= ex_b;
+            default: ex_taken = 0;
+        endcase
+        ex_taken = ex_taken && ex_is_branch;
+
+        if (id_ex_unknown || (id_ex_class != `PERF_CLASS_RV_JUMP && !ex_taken)) ex_npc = id_ex_pc + 4;
+        else if (id_ex_instr[6:0] == `RV_OP_JALR) ex_npc = (ex_a + id_ex_imm) & ~64'h1;
+        else ex_npc = id_ex_pc + id_ex_imm; // Taken branch or JAL
+    end
+
+    wire ex_redirect = id_ex_valid && ex_npc != id_ex_pred_npc;
+
+    // === MEM: DATA PORT ===
+    wire mem_is_load = ex_mem_valid && !ex_mem_unknown && ex_mem_class == `PERF_CLASS_RV_LOAD;
+    wire mem_is_store = ex_mem_valid && !ex_mem_unknown && ex_mem_class == `PERF_CLASS_RV_STORE;
+
+    // === WB: COMMIT ===
+    wire wb_switch = mem_wb_valid && mem_wb_instr == `RV_MODE_SWITCH;
+    wire wb_wfi = run && mem_wb_valid && mem_wb_instr == `RV_WFI;
+    wire squash = (start_x86 && handoff) || wb_wfi; // Nothing younger may take effect
+
+    assign start_x86 = run && wb_switch;
+    assign start_x86_rip = mem_wb_pc + 4;
+
+    // A vle/vse with no active elements makes no access
+    assign data_req = run && !squash && (mem_is_load || mem_is_store) && !(ex_mem_vec && ex_mem_vbytes == 0);
+    assign data_we = mem_is_store;
+    assign data_bytes = ex_mem_vec ? ex_mem_vbytes : 5'd1 << ex_mem_instr[13:12];
+    assign data_addr = ex_mem_result;
+    assign data_wdata = ex_mem_vec ? ex_mem_vresult : {64'h0, ex_mem_store_data};
+    wire mem_stall = data_req && !data_gnt;
+
+    // IF hands a word to ID only when nothing downstream holds or redirects it
+    assign fetch_req = run && !idle;
+    assign fetch_commit = run && !idle && fetch_ready && !squash && !mem_stall && !ex_redirect && !load_use;
+
+    reg [63:0] mem_result;
+    always @(*) begin
+        case (ex_mem_instr[14:12])
+            3'b000: mem_result = {{56{data_rdata[7]}}, data_rdata[7:0]};    // LB
+            3'b001: mem_result = {{48{data_rdata[15]}}, data_rdata[15:0]};  // LH
+            3'b010: mem_result = {{32{data_rdata[31]}}, data_rdata[31:0]};  // LW
+            3'b100: mem_result = {56'h0, data_rdata[7:0]};                  // LBU
+            3'b101: mem_result = {48'h0, data_rdata[15:0]};                 // LHU
+            3'b110: mem_result = {32'h0, data_rdata[31:0]};                 // LWU
+            default: mem_result = data_rdata[63:0];                         // LD
+        endcase
+        if (!mem_is_load) mem_result = ex_mem_result;
+    end
+
+    wire [`VEC_VLEN-1:0] mem_vresult = (mem_is_load && ex_mem_vec) ? vec_merge(data_rdata, ex_mem_vresult, ex_mem_vmask)
+                                                                   : ex_mem_vresult;
+
+    initial begin
+        pc = 0;
+        fetch_pc = 0;
+        idle = 0;
+        reg_out = 0;
+        debug_instr = 0;
+        if_id_valid = 0;
+        id_ex_valid = 0;
+        ex_mem_valid = 0;
+        mem_wb_valid = 0;
+        clear_perf_counters();
+        clear_predictor();
+        for (integer i = 0; i < 32; i = i + 1) begin
+            regs[i] = 0;
+            vregs[i] = 0;
+        end
+        vl = 0;
+        vsew = `VEC_SEW_8;
+    end
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            pc <= boot_pc;
+            fetch_pc <= boot_pc;
+            idle <= 0;
+            reg_out <= 0;
+            retire_valid <= 0;
+            retire_wen <= 0;
+            if_id_valid <= 0;
+            id_ex_valid <= 0;
+            ex_mem_valid <= 0;
+            mem_wb_valid <= 0;
+            clear_perf_counters();
+            clear_predictor();
+            // Registers stay initialized from initial block
+        end else begin
+            // Trace port defaults; perf_retire/trace_write override them
+            retire_valid <= 0;
+            retire_wen <= 0;
+            retire_rd <= 0;
+            retire_value <= 0;
+
+            if (run) begin
+                mcycle <= mcycle + 1;
+                if (idle) begin
+                    idle_cycles <= idle_cycles + 1; // Parked in WFI: nothing else moves
+                end else begin
+                    writeback_stage();
+
+                    if (squash) begin
+                        if_id_valid <= 0;
+                        id_ex_valid <= 0;
+                        ex_mem_valid <= 0;
+                        mem_wb_valid <= 0;
+                        fetch_pc <= wb_wfi ? mem_wb_npc : start_x86_rip;
+                        flushes <= flushes + 1;
+                    end else if (mem_stall) begin
+                        // Data port busy: freeze IF..MEM, keeping EX operands that WB forwards now
+                        mem_wb_valid <= 0;
+                        id_ex_rs1_val <= ex_a;
+                        id_ex_rs2_val <= ex_b;
+                        id_ex_vs1_val <= ex_vs1;
+                        id_ex_vs2_val <= ex_vs2;
+                        id_ex_vd_val <= ex_vd_old;
+                        stall_cycles <= stall_cycles + 1;
+                    end else begin
+                        memory_stage();
+                        execute_stage();
+                        if (ex_redirect) begin
+                            if_id_valid <= 0;
+                            id_ex_valid <= 0;
+                            fetch_pc <= ex_npc;
+                            flushes <= flushes + 1;
+                        end else if (load_use) begin
+                            id_ex_valid <= 0; // Bubble; IF/ID and fetch_pc hold
+                            stall_cycles <= stall_cycles + 1;
+                        end else begin
+                            decode_stage();
+                            fetch_stage();
+                        end
+                    end
+                end
+            end
+        end
+    end
+
+    // === PERFORMANCE COUNTERS ===
+    task clear_perf_counters;
+        begin
+            mcycle <= 0;
+            minstret <= 0;
+            mode_switches <= 0;
+            unknown_skips <= 0;
+            idle_cycles <= 0;
+            stall_cycles <= 0;
+            flushes <= 0;
+            branches <= 0;
+            mispredicts <= 0;
+            simd_ops <= 0;
+            simd_elements <= 0;
+            for (integer i = 0; i < 8; i = i + 1) begin
+                perf_class_retired[i] <= 0;
+            end
+            for (integer i = 0; i < `VEC_LANES; i = i + 1) begin
+                simd_lane_active[i] <= 0;
+            end
+        end
+    endtask
+
+    task clear_predictor;
+        begin
+            bp_history <= 0;
+            for (integer i = 0; i < BP_ENTRIES; i = i + 1) begin
+                bp_counters[i] <= 2'b01; // Weakly not taken
+            end
+        end
+    endtask
+
+    task perf_retire;
+        input [3:0] perf_class;
+        begin
+            minstret <= minstret + 1;
+            perf_class_retired[perf_class[2:0]] <= perf_class_retired[perf_class[2:0]] + 1;
+            retire_valid <= 1;
+        end
+    endtask
+
+    // Vector instruction retired: a lane counts when any of its bytes was active
+    task simd_retire;
+        input [`VEC_VLENB-1:0] byte_mask;
+        input [4:0] elements;
+        begin
+            simd_ops <= simd_ops + 1;
+            simd_elements <= simd_elements + {59'h0, elements};
+            for (integer i = 0; i < `VEC_LANES; i = i + 1) begin
+                if (byte_mask[i*(`VEC_LANE_BITS/8) +: `VEC_LANE_BITS/8] != 0)
+                    simd_lane_active[i] <= simd_lane_active[i] + 1;
+            end
+        end
+    endtask
+
+    // Register write of the retiring instruction, for the trace port
+    task trace_write;
+        input [4:0] rd;
+        input [63:0] value;
+        begin
+            retire_wen <= 1;
+            retire_rd <= rd;
+            retire_value <= value;
+        end
+    endtask
+
+    // === PIPELINE STAGES ===
+    task fetch_stage;
+        begin
+            if (fetch_ready) begin
+                if_id_valid <= 1;
+                if_id_pc <= fetch_pc;
+                if_id_instr <= fetch_data;
+                if_id_pred_npc <= if_pred_npc;
+                if_id_bp_index <= if_bp_index;
+                fetch_pc <= if_pred_npc;
+            end else begin
+                if_id_valid <= 0; // L1I miss: bubble, fetch_pc holds
+            end
+        end
+    endtask
+
+    task decode_stage;
+        begin
+            id_ex_valid <= if_id_valid;
+            id_ex_pc <= if_id_pc;
+            id_ex_instr <= if_id_instr;
+            id_ex_pred_npc <= if_id_pred_npc;
+            id_ex_bp_index <= if_id_bp_index;
+            id_ex_imm <= id_imm;
+            id_ex_rs1_val <= id_rs1_val;
+            id_ex_rs2_val <= id_rs2_val;
+            id_ex_class <= id_class;
+            id_ex_writes_rd <= id_writes_rd;
+            id_ex_unknown <= id_unknown;
+            id_ex_vec <= id_vec;
+            id_ex_writes_vd <= id_writes_vd;
+            id_ex_vs1_val <= id_vs1_val;
+            id_ex_vs2_val <= id_vs2_val;
+            id_ex_vd_val <= id_vd_val;
+        end
+    endtask
+
+    task execute_stage;
+        begin
+            ex_mem_valid <= id_ex_valid;
+            ex_mem_pc <= id_ex_pc;
+            ex_mem_instr <= id_ex_instr;
+            ex_mem_imm <= id_ex_imm;
+            ex_mem_result <= ex_result;
+            ex_mem_store_data <= ex_b;
+            ex_mem_npc <= ex_npc;
+            ex_mem_class <= id_ex_class;
+            ex_mem_writes_rd <= id_ex_writes_rd;
+            ex_mem_unknown <= id_ex_unknown;
+            ex_mem_vec <= id_ex_vec;
+            ex_mem_writes_vd <= id_ex_writes_vd;
+            ex_mem_vresult <= ex_vresult;
+            ex_mem_vmask <= ex_vmask;
+            ex_mem_vbytes <= ex_velems << ex_eew;
+            ex_mem_velems <= ex_velems;
+
+            // Train the predictor with the resolved direction
+            if (id_ex_valid && ex_is_branch) begin
+                branches <= branches + 1;
+                if (ex_redirect) mispredicts <= mispredicts + 1;
+                if (ex_taken && bp_counters[id_ex_bp_index] != 2'b11)
+                    bp_counters[id_ex_bp_index] <= bp_counters[id_ex_bp_index] + 1;
+                else if (!ex_taken && bp_counters[id_ex_bp_index] != 2'b00)
+                    bp_counters[id_ex_bp_index] <= bp_counters[id_ex_bp_index] - 1;
+                bp_history <= {bp_history[BP_INDEX_BITS-2:0], ex_taken};
+            end
+        end
+    endtask
+
+    task memory_stage;
+        begin
+            mem_wb_valid <= ex_mem_valid;
+            mem_wb_pc <= ex_mem_pc;
+            mem_wb_instr <= ex_mem_instr;
+            mem_wb_imm <= ex_mem_imm;
+            mem_wb_result <= mem_result;
+            mem_wb_npc <= ex_mem_npc;
+            mem_wb_class <= ex_mem_class;
+            mem_wb_writes_rd <= ex_mem_writes_rd;
+            mem_wb_unknown <= ex_mem_unknown;
+            mem_wb_vec <= ex_mem_vec;
+            mem_wb_writes_vd <= ex_mem_writes_vd;
+            mem_wb_vresult <= mem_vresult;
+            mem_wb_vmask <= ex_mem_vmask;
+            mem_wb_velems <= ex_mem_velems;
+        end
+    endtask
+
+    task writeback_stage;
+        begin
+            if (mem_wb_valid) begin
+                if (mem_wb_unknown) begin
+                    unknown_skips <= unknown_skips + 1; // Skip unknown instructions
+                end else begin
+                    perf_retire(mem_wb_class);
+                    if (wb_switch) mode_switches <= mode_switches + 1;
+                    if (wb_wfi) idle <= 1;
+                    if (mem_wb_writes_rd) begin
+                        regs[wb_rd] <= mem_wb_result;
+                        reg_out <= mem_wb_result;
+                        trace_write(wb_rd, mem_wb_result);
+                    end
+                    if (mem_wb_writes_vd) vregs[wb_rd] <= mem_wb_vresult;
+                    if (mem_wb_vec) simd_retire(mem_wb_vmask, mem_wb_velems);
+                    if (wb_is_vsetvli) begin
+                        vl <= mem_wb_result[4:0];
+                        vsew <= mem_wb_instr[24:23];
+                    end
+                end
+                pc <= mem_wb_npc;
+
+                // Update debug outputs
+                debug_instr <= mem_wb_instr;
+                debug_opcode <= mem_wb_instr[6:0];
+                debug_rd <= mem_wb_instr[11:7];
+                debug_rs1 <= mem_wb_instr[19:15];
+                debug_imm <= mem_wb_imm;
+                debug_alu_result <= mem_wb_result;
+                retire_pc <= mem_wb_pc;
+                retire_instr <= mem_wb_instr;
+            end
+        end
+    endtask
+
+    // === IMMEDIATES ===
+    function [63:0] imm_i;
+        input [31:0] instr;
+        imm_i = {{52{instr[31]}}, instr[31:20]};
+    endfunction
+
+    function [63:0] imm_s;
+        input [31:0] instr;
+        imm_s = {{52{instr[31]}}, instr[31:25], instr[11:7]};
+    endfunction
+
+    function [63:0] imm_b;
+        input [31:0] instr;
+        imm_b = {{52{instr[31]}}, instr[7], instr[30:25], instr[11:8], 1'b0};
+    endfunction
+
+    function [63:0] imm_u;
+        input [31:0] instr;
+        imm_u = {{32{instr[31]}}, instr[31:12], 12'h0};
+    endfunction
+
+    function [63:0] imm_j;
+        input [31:0] instr;
+        imm_j = {{44{instr[31]}}, instr[19:12], instr[20], instr[30:21], 1'b0};
+    endfunction
+
+    // ADD(I)W, SLL(I)W and SRL(I)W/SRA(I)W are the only RV64 word ALU ops
+    function is_word_funct3;
+        input [2:0] funct3;
+        is_word_funct3 = funct3 == `RV_FUNCT3_ADD || funct3 == `RV_FUNCT3_SLL || funct3 == `RV_FUNCT3_SRL;
+    endfunction
+
+    // Register-register funct7: base ops, RV64M, or SUB/SRA (the only users of the alternate encoding)
+    function is_reg_funct;
+        input [6:0] funct7;
+        input [2:0] funct3;
+        is_reg_funct = funct7 == `RV_FUNCT7_NORMAL || funct7 == `RV_FUNCT7_MULDIV ||
+                       (funct7 == `RV_FUNCT7_ALT && (funct3 == `RV_FUNCT3_ADD || funct3 == `RV_FUNCT3_SRL));
+    endfunction
+
+    // === VECTOR DECODE + HELPERS ===
+    function is_vsetvli;
+        input [31:0] instr;
+        is_vsetvli = instr[6:0] == `RV_OP_V && instr[14:12] == `RV_FUNCT3_OPCFG && !instr[31];
+    endfunction
+
+    // Unmasked vadd.vv/.vx and vmul.vv/.vx
+    function is_vector_arith;
+        input [31:0] instr;
+        is_vector_arith = instr[25] && (
+            (instr[31:26] == `RV_FUNCT6_VADD && (instr[14:12] == `RV_FUNCT3_OPIVV || instr[14:12] == `RV_FUNCT3_OPIVX)) ||
+            (instr[31:26] == `RV_FUNCT6_VMUL && (instr[14:12] == `RV_FUNCT3_OPMVV || instr[14:12] == `RV_FUNCT3_OPMVX)));
+    endfunction
+
+    // Unit-stride, unmasked, single-field vle/vse of 8/16/32/64-bit elements
+    function is_vector_mem;
+        input [31:0] instr;
+        is_vector_mem = instr[31:25] == 7'b0000001 && instr[24:20] == 0 &&
+                        (instr[14:12] == `RV_VWIDTH_8 || instr[14:12] == `RV_VWIDTH_16 ||
+                         instr[14:12] == `RV_VWIDTH_32 || instr[14:12] == `RV_VWIDTH_64);
+    endfunction
+
+    function [1:0] vec_sew_of_width;
+        input [2:0] width;
+        case (width)
+            `RV_VWIDTH_16: vec_sew_of_width = `VEC_SEW_16;
+            `RV_VWIDTH_32: vec_sew_of_width = `VEC_SEW_32;
+            `RV_VWIDTH_64: vec_sew_of_width = `VEC_SEW_64;
+            default: vec_sew_of_width = `VEC_SEW_8;
+        endcase
+    endfunction
+
+    // Bytes of the first `elements` elements
+    function [`VEC_VLENB-1:0] vec_byte_mask;
+        input [4:0] elements;
+        input [1:0] sew;
+        for (integer i = 0; i < `VEC_VLENB; i = i + 1)
+            vec_byte_mask[i] = (i >> sew) < elements;
+    endfunction
+
+    // Active bytes from a, the rest (tail) from b
+    function [`VEC_VLEN-1:0] vec_merge;
+        input [`VEC_VLEN-1:0] a, b;
+        input [`VEC_VLENB-1:0] byte_mask;
+        for (integer i = 0; i < `VEC_VLENB; i = i + 1)
+            vec_merge[i*8 +: 8] = byte_mask[i] ? a[i*8 +: 8] : b[i*8 +: 8];
+    endfunction
+
+    // Scalar operand of a .vx op in every element
+    function [`VEC_VLEN-1:0] vec_splat;
+        input [63:0] x;
+        input [1:0] sew;
+        case (sew)
+            `VEC_SEW_8: vec_splat = {16{x[7:0]}};
+            `VEC_SEW_16: vec_splat = {8{x[15:0]}};
+            `VEC_SEW_32: vec_splat = {4{x[31:0]}};
+            default: vec_splat = {2{x}};
+        endcase
+    endfunction
+
+    // === FAST ALU OPERATIONS ===
+    function [63:0] alu64;
+        input [2:0] funct3;
+        input sub, sra, mul;
+        input [63:0] a, b;
+        begin
+            if (mul) begin
+                alu64 = funct3 == `RV_FUNCT3_ADD ? a * b : a; // MUL; rest of RV64M not implemented: pass rs1 through
+            end else begin
+                case (funct3)
+                    `RV_FUNCT3_ADD: alu64 = sub ? a - b : a + b;
+                    `RV_FUNCT3_SLL: alu64 = a << b[5:0];
+                    `RV_FUNCT3_SLT: alu64 = {63'h0, $signed(a) < $signed(b)};
+                    `RV_FUNCT3_SLTU: alu64 = {63'h0, a < b};
+                    `RV_FUNCT3_XOR: alu64 = a ^ b;
+                    `RV_FUNCT3_SRL: begin
+                        // Separate assignments keep >>> signed (a ?: with an unsigned arm would not)
+                        if (sra) alu64 = $signed(a) >>> b[5:0];
+                        else alu64 = a >> b[5:0];
+                    end
+                    `RV_FUNCT3_OR: alu64 = a | b;
+                    default: alu64 = a & b;
+                endcase
+            end
+        end
+    endfunction
+
+    // RV64 *W operations: 32-bit result, sign-extended
+    function [63:0] alu32;
+        input [2:0] funct3;
+        input sub, sra, mul;
+        input [63:0] a, b;
+        reg [31:0] result;
+        begin
+            if (mul && funct3 != `RV_FUNCT3_ADD) begin
+                alu32 = a; // Only MULW: pass rs1 through
+            end else begin
+                case (funct3)
+                    `RV_FUNCT3_SLL: result = a[31:0] << b[4:0];
+                    `RV_FUNCT3_SRL: begin
+                        if (sra) result = $signed(a[31:0]) >>> b[4:0];
+                        else result = a[31:0] >> b[4:0];
+                    end
+                    default: result = mul ? a[31:0] * b[31:0] : sub ? a[31:0] - b[31:0] : a[31:0] + b[31:0];
+                endcase
+                alu32 = {{32{result[31]}}, result};
+            end
+        end
+    endfunction
+
+endmodule
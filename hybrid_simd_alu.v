@@ -0,0 +1,35 @@
+// FAST SIMD ALU
+// Combinational packed-integer datapath: one VEC_VLEN-bit operation on
+// 8/16/32/64-bit elements per cycle. Both cores instantiate it (they can run
+// in the same cycle); masking and tail handling stay in the cores, which know
+// their own vl/element rules.
+
+`include "simd_constants.vh"
+
+module hybrid_simd_alu (
+    input [1:0] op,                 // `VEC_OP_*
+    input [1:0] sew,                // `VEC_SEW_*
+    input [`VEC_VLEN-1:0] a,
+    input [`VEC_VLEN-1:0] b,
+    output reg [`VEC_VLEN-1:0] result
+);
+
+    always @(*) begin
+        result = 0;
+        case (sew)
+            `VEC_SEW_8:
+                for (integer i = 0; i < `VEC_VLEN / 8; i = i + 1)
+                    result[i*8 +: 8] = op == `VEC_OP_MUL ? a[i*8 +: 8] * b[i*8 +: 8] : a[i*8 +: 8] + b[i*8 +: 8];
+            `VEC_SEW_16:
+                for (integer i = 0; i < `VEC_VLEN / 16; i = i + 1)
+                    result[i*16 +: 16] = op == `VEC_OP_MUL ? a[i*16 +: 16] * b[i*16 +: 16] : a[i*16 +: 16] + b[i*16 +: 16];
+            `VEC_SEW_32:
+                for (integer i = 0; i < `VEC_VLEN / 32; i = i + 1)
+                    result[i*32 +: 32] = op == `VEC_OP_MUL ? a[i*32 +: 32] * b[i*32 +: 32] : a[i*32 +: 32] + b[i*32 +: 32];
+            default:
+                for (integer i = 0; i < `VEC_VLEN / 64; i = i + 1)
+                    result[i*64 +: 64] = op == `VEC_OP_MUL ? a[i*64 +: 64] * b[i*64 +: 64] : a[i*64 +: 64] + b[i*64 +: 64];
+        endcase
+    end
+
+endmodule
@@ -0,0 +1,85 @@
+// FAST CONSOLE UART
+// Transmit-only 16550-style console on the arbiter's data port. Guest writes
+// to THR queue bytes in a small TX FIFO; the FIFO drains one byte every
+// TX_CYCLES cycles into the harness console (guest_console.h) through DPI-C,
+// where the bytes are batched before any host I/O happens. LSR reports
+// whether the FIFO has room (THRE) and whether it is empty (TEMT). A write to
+// a full FIFO is dropped, like a real UART overrun, and counted.
+
+`include "mem_constants.vh"
+
+module hybrid_uart #(
+    parameter FIFO_DEPTH = `CONSOLE_FIFO_DEPTH,
+    parameter TX_CYCLES = `CONSOLE_DEFAULT_TX_CYCLES
+) (
+    input clk,
+    input rst,
+
+    // Register access (offset within the MMIO page); reads are combinational
+    input write,
+    input [2:0] reg_offset,
+    input [7:0] wdata,
+    output [63:0] rdata,
+
+    // Statistics
+    output reg [63:0] tx_bytes,     // Bytes handed to the host
+    output reg [63:0] tx_overruns   // THR writes dropped on a full FIFO
+);
+
+    // === HOST SIDE (GuestConsole in the harness, via DPI-C) ===
+    import "DPI-C" function void guest_console_tx(input longint handle, input int data);
+
+    reg [63:0] console_handle /*verilator public_flat_rw*/; // GuestConsole*, set by attach_console()
+
+    localparam PTR_BITS = $clog2(FIFO_DEPTH);
+
+    // === TX FIFO ===
+    reg [7:0] fifo [0:FIFO_DEPTH-1];
+    reg [PTR_BITS-1:0] head;
+    reg [PTR_BITS:0] count /*verilator public_flat*/;
+    reg [31:0] tx_timer /*verilator public_flat*/;  // Cycles until the next byte may leave
+
+    wire fifo_full = count == FIFO_DEPTH;
+    wire push = write && reg_offset == `CONSOLE_REG_THR;
+    wire pop = count != 0 && tx_timer == 0;
+    wire [PTR_BITS-1:0] tail = head + count[PTR_BITS-1:0];
+
+    // === REGISTERS (the addressed register in byte 0, like a byte-wide bus) ===
+    wire [7:0] lsr = ({7'h0, !fifo_full} << `CONSOLE_LSR_THRE) | ({7'h0, count == 0} << `CONSOLE_LSR_TEMT);
+    assign rdata = reg_offset == `CONSOLE_REG_LSR ? {56'h0, lsr} : 64'h0;
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            head <= 0;
+            count <= 0;
+            tx_timer <= 0;
+            tx_bytes <= 0;
+            tx_overruns <= 0;
+        end else begin
+            if (pop) begin
+                guest_console_tx(console_handle, {24'h0, fifo[head]});
+                head <= head + 1;
+                tx_bytes <= tx_bytes + 1;
+                tx_timer <= TX_CYCLES - 1;
+            end else if (tx_timer != 0) begin
+                tx_timer <= tx_timer - 1;
+            end
+
+            // A byte leaving this cycle frees its slot for the push
+            if (push && (!fifo_full || pop)) fifo[tail] <= wdata;
+            if (push && fifo_full && !pop) tx_overruns <= tx_overruns + 1;
+            count <= count + ((push && (!fifo_full || pop)) ? 1 : 0) - (pop ? 1 : 0);
+        end
+    end
+
+    // The handle survives reset; attach_console() sets it after the initial blocks run
+    initial begin
+        console_handle = 0;
+        head = 0;
+        count = 0;
+        tx_timer = 0;
+        tx_bytes = 0;
+        tx_overruns = 0;
+    end
+
+endmodule
@@ -0,0 +1,356 @@
+// FAST x86-64 CORE
+// Simplified long-mode x86 with its own fetch port into the shared memory
+// arbiter. Runs while the top level keeps it enabled; start loads a new RIP.
+// A fetch that misses the shared L1I stalls the core until the line arrives.
+// OUT and the MOVDQU memory forms use the data port (OUT stores AL to the
+// console page) and stall while the RISC-V core holds it or the L1D misses.
+// SSE packed-integer ops run on xmm0-7 through the shared SIMD ALU
+// (hybrid_simd_alu.v). Instructions are fixed 4-byte words like the rest of
+// this core, except PMULLD: its 5 bytes are padded with NOPs to 8 and the core
+// fetches the second word (ModRM + padding) in an extra cycle.
+// HLT parks the core (idle) with RIP past it; the next start wakes it. A parked
+// core does not fetch and only counts mcycle and idle_cycles.
+
+`include "x86_constants.vh"
+`include "mem_constants.vh"
+`include "simd_constants.vh"
+
+module hybrid_x86_core (
+    input clk,
+    input rst,
+    input run,                      // Core executes this cycle
+    input [63:0] boot_rip,
+    input [63:0] boot_rflags,
+    input start,                    // Load start_rip (takes priority over execution, wakes HLT)
+    input [63:0] start_rip,
+
+    // Instruction fetch (memory arbiter port, through the shared L1I)
+    output fetch_req,
+    output fetch_commit,            // The fetched word executes this cycle
+    output [63:0] fetch_addr,
+    input [31:0] fetch_data,
+    input fetch_ready,              // L1I hit: fetch_data is valid
+
+    // Data port (memory arbiter, shared with the RISC-V core)
+    output data_req,
+    output data_we,
+    output [4:0] data_bytes,
+    output [63:0] data_addr,
+    output [`VEC_VLEN-1:0] data_wdata,
+    input data_gnt,
+    input [`VEC_VLEN-1:0] data_rdata,
+
+    // Architectural / debug outputs
+    output reg [63:0] x86_rip /*verilator public_flat_rw*/,
+    output reg [63:0] x86_rflags,
+    output [63:0] x86_rax,
+    output [63:0] x86_rcx,
+    output [63:0] x86_rdx,
+    output [63:0] x86_rbx,
+    output reg [1:0] x86_mode,
+    output reg x86_long_mode,
+    output reg x86_cf, x86_zf, x86_sf, x86_of,
+    output reg [31:0] debug_instr,
+    output reg idle /*verilator public_flat_rw*/, // Parked by HLT until the next start
+
+    // Performance counters (cycles this core ran, instructions it retired)
+    output reg [63:0] mcycle /*verilator public_flat_rw*/,
+    output reg [63:0] minstret /*verilator public_flat_rw*/,
+    output reg [63:0] unknown_skips /*verilator public_flat_rw*/,
+    output reg [63:0] idle_cycles /*verilator public_flat_rw*/, // Cycles spent parked in HLT
+    output reg [63:0] simd_ops,     // SSE instructions retired
+    output reg [63:0] simd_elements,// Elements they processed (MOVDQU: bytes)
+
+    // Retirement trace port
+    output reg retire_valid,
+    output reg [63:0] retire_pc /*verilator public_flat_rw*/,
+    output reg [31:0] retire_instr,
+    output reg retire_wen,
+    output reg [4:0] retire_rd,
+    output reg [63:0] retire_value
+);
+
+    // === REGISTER FILE ===
+    reg [63:0] x86_regs [0:15] /*verilator public_flat_rw*/;
+    reg [`VEC_VLEN-1:0] xmm [0:7] /*verilator public_flat_rw*/;
+
+    // Retired instructions per opcode class (PERF_CLASS_X86_* minus 8)
+    reg [63:0] perf_class_retired [0:7] /*verilator public_flat_rw*/;
+
+    // Retired SSE instructions that used each `VEC_LANE_BITS lane
+    reg [63:0] simd_lane_active [0:`VEC_LANES-1] /*verilator public_flat*/;
+
+    // PMULLD's first word executed; the next fetch (rip + 4) is its ModRM word
+    reg sse_escape;
+
+    assign x86_rax = x86_regs[0];
+    assign x86_rcx = x86_regs[1];
+    assign x86_rdx = x86_regs[2];
+    assign x86_rbx = x86_regs[3];
+
+    assign fetch_addr = sse_escape ? x86_rip + 64'd4 : x86_rip;
+    assign fetch_req = run && !idle;
+    assign fetch_commit = run && !idle && fetch_ready && (!data_req || data_gnt);
+
+    // OUT imm8, AL: one byte to console register imm8
+    wire fetch_is_out = !sse_escape && fetch_data[7:0] == `X86_PREFIX_REX_W && fetch_data[15:8] == `X86_OP_OUT_IMM;
+
+    // MOVDQU xmm, [reg] / MOVDQU [reg], xmm: 16 bytes at a base register, any alignment
+    wire fetch_is_movdqu = !sse_escape && fetch_data[7:0] == `X86_PREFIX_REP && fetch_data[15:8] == `X86_OP_ESCAPE &&
+                           (fetch_data[23:16] == `X86_OP_MOVDQU_LD || fetch_data[23:16] == `X86_OP_MOVDQU_ST);
+    wire fetch_is_movdqu_mem = fetch_is_movdqu && sse_mem_modrm(fetch_data[31:24]);
+    wire movdqu_store = fetch_data[23:16] == `X86_OP_MOVDQU_ST;
+
+    assign data_req = run && !idle && fetch_ready && (fetch_is_out || fetch_is_movdqu_mem);
+    assign data_we = fetch_is_out || movdqu_store;
+    assign data_bytes = fetch_is_out ? 5'd1 : `VEC_VLENB;
+    assign data_addr = fetch_is_out ? `CONSOLE_BASE + {56'h0, fetch_data[23:16]} : x86_regs[{1'b0, fetch_data[26:24]}];
+    assign data_wdata = fetch_is_out ? {120'h0, x86_regs[0][7:0]} : xmm[fetch_data[29:27]];
+
+    // PADDQ / PMULLD on the shared SIMD ALU: xmm[reg] op= xmm[rm]
+    // (PMULLD's ModRM is byte 0 of its second word)
+    wire [2:0] sse_reg = sse_escape ? fetch_data[5:3] : fetch_data[29:27];
+    wire [2:0] sse_rm = sse_escape ? fetch_data[2:0] : fetch_data[26:24];
+    wire [`VEC_VLEN-1:0] sse_result;
+
+    hybrid_simd_alu simd (
+        .op(sse_escape ? `VEC_OP_MUL : `VEC_OP_ADD), .sew(sse_escape ? `VEC_SEW_32 : `VEC_SEW_64),
+        .a(xmm[sse_reg]), .b(xmm[sse_rm]), .result(sse_result)
+    );
+
+    initial begin
+        x86_rip = 64'h400000;
+        x86_rflags = 64'h202;  // IF=1, Reserved=1
+        x86_mode = 2'b10;      // Long mode
+        x86_long_mode = 1;
+        x86_cf = 0;
+        x86_zf = 0;
+        x86_sf = 0;
+        x86_of = 0;
+        debug_instr = 0;
+        sse_escape = 0;
+        idle = 0;
+        clear_perf_counters();
+        for (integer i = 0; i < 8; i = i + 1) begin
+            xmm[i] = 0;
+        end
+
+        // Initialize key registers with interesting FAST values
+        x86_regs[0] = 64'h1234567890ABCDEF; // RAX - FAST signature!
+        x86_regs[1] = 64'hBEEFCAFE12345678; // RCX
+        x86_regs[2] = 64'hDEADBEEF87654321; // RDX
+        x86_regs[3] = 64'hCAFEBABE13579BDF; // RBX
+    end
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            x86_rip <= boot_rip;
+            x86_rflags <= boot_rflags;
+            x86_cf <= boot_rflags[`X86_FLAG_CF];
+            x86_zf <= boot_rflags[`X86_FLAG_ZF];
+            x86_sf <= boot_rflags[`X86_FLAG_SF];
+            x86_of <= boot_rflags[`X86_FLAG_OF];
+            retire_valid <= 0;
+            retire_wen <= 0;
+            sse_escape <= 0;
+            idle <= 0;
+            clear_perf_counters();
+        end else begin
+            // Trace port defaults; perf_retire/trace_write override them
+            retire_valid <= 0;
+            retire_wen <= 0;
+            retire_rd <= 0;
+            retire_value <= 0;
+
+            if (run) begin
+                mcycle <= mcycle + 1;
+                if (idle) idle_cycles <= idle_cycles + 1; // Parked in HLT
+                // Else stalled on an L1I miss or waiting for the data port
+                else if (fetch_ready && (!data_req || data_gnt)) execute_x86_fast();
+            end
+            if (start) begin // Redirect wins over the RIP update
+                x86_rip <= start_rip;
+                sse_escape <= 0;
+                idle <= 0;
+            end
+        end
+    end
+
+    // === PERFORMANCE COUNTERS ===
+    task clear_perf_counters;
+        begin
+            mcycle <= 0;
+            minstret <= 0;
+            unknown_skips <= 0;
+            idle_cycles <= 0;
+            simd_ops <= 0;
+            simd_elements <= 0;
+            for (integer i = 0; i < 8; i = i + 1) begin
+                perf_class_retired[i] <= 0;
+            end
+            for (integer i = 0; i < `VEC_LANES; i = i + 1) begin
+                simd_lane_active[i] <= 0;
+            end
+        end
+    endtask
+
+    task perf_retire;
+        input [3:0] perf_class;
+        begin
+            minstret <= minstret + 1;
+            perf_class_retired[perf_class[2:0]] <= perf_class_retired[perf_class[2:0]] + 1;
+            retire_valid <= 1;
+        end
+    endtask
+
+    // SSE instruction retired; every xmm op is full width, so all lanes are busy
+    task simd_retire;
+        input [4:0] elements;
+        begin
+            simd_ops <= simd_ops + 1;
+            simd_elements <= simd_elements + {59'h0, elements};
+            for (integer i = 0; i < `VEC_LANES; i = i + 1) begin
+                simd_lane_active[i] <= simd_lane_active[i] + 1;
+            end
+        end
+    endtask
+
+    // Register write of the retiring instruction, for the trace port
+    task trace_write;
+        input [4:0] rd;
+        input [63:0] value;
+        begin
+            retire_wen <= 1;
+            retire_rd <= rd;
+            retire_value <= value;
+        end
+    endtask
+
+    // === OPTIMIZED x86 EXECUTION ===
+    task execute_x86_fast;
+        reg [31:0] instr;
+        begin
+            // Simplified x86 execution for FAST mode
+            instr = fetch_data;
+
+            // Basic x86 decode (simplified for performance)
+            if (sse_escape) begin
+                // Second PMULLD word: ModRM, then NOP padding the core consumes
+                xmm[sse_reg] <= sse_result;
+                x86_rip <= x86_rip + 8;
+                sse_escape <= 0;
+                perf_retire(`PERF_CLASS_X86_SIMD);
+                simd_retire(5'd4);
+                instr = debug_instr; // Report the instruction by its first word
+            end else case (instr[7:0])
+                `X86_PREFIX_REX_W: begin // REX.W prefix - 64-bit operation
+                    fast_x86_alu(instr);
+                    x86_rip <= x86_rip + 4; // Simplified length
+                    perf_retire(instr[15:8] == `X86_OP_OUT_IMM ? `PERF_CLASS_X86_IO : `PERF_CLASS_X86_ALU);
+                end
+
+                `X86_OP_NOP: begin
+                    x86_rip <= x86_rip + 1;
+                    perf_retire(`PERF_CLASS_X86_NOP);
+                end
+
+                `X86_OP_HLT: begin
+                    x86_rip <= x86_rip + 1;
+                    perf_retire(`PERF_CLASS_X86_HALT);
+                    idle <= 1;
+                end
+
+                `X86_PREFIX_OPSZ, `X86_PREFIX_REP: begin // SSE packed-integer forms
+                    if (instr[15:8] == `X86_OP_ESCAPE && instr[7:0] == `X86_PREFIX_OPSZ &&
+                        instr[23:16] == `X86_OP_ESCAPE_38 && instr[31:24] == `X86_OP_PMULLD) begin
+                        sse_escape <= 1; // rip holds until the ModRM word executes
+                    end else if (instr[15:8] == `X86_OP_ESCAPE && instr[7:0] == `X86_PREFIX_OPSZ &&
+                                 instr[23:16] == `X86_OP_PADDQ && instr[31:30] == `X86_MOD_REG) begin
+                        xmm[sse_reg] <= sse_result;
+                        x86_rip <= x86_rip + 4;
+                        perf_retire(`PERF_CLASS_X86_SIMD);
+                        simd_retire(5'd2);
+                    end else if (fetch_is_movdqu && (instr[31:30] == `X86_MOD_REG || fetch_is_movdqu_mem)) begin
+                        if (!movdqu_store)
+                            xmm[instr[29:27]] <= fetch_is_movdqu_mem ? data_rdata : xmm[instr[26:24]];
+                        else if (!fetch_is_movdqu_mem)
+                            xmm[instr[26:24]] <= xmm[instr[29:27]];
+                        x86_rip <= x86_rip + 4;
+                        perf_retire(`PERF_CLASS_X86_SIMD);
+                        simd_retire(`VEC_VLENB);
+                    end else begin
+                        x86_rip <= x86_rip + 1; // Skip unknown
+                        unknown_skips <= unknown_skips + 1;
+                    end
+                end
+
+                default: begin
+                    x86_rip <= x86_rip + 1; // Skip unknown
+                    unknown_skips <= unknown_skips + 1;
+                end
+            endcase
+
+            debug_instr <= instr;
+            retire_pc <= x86_rip;
+            retire_instr <= instr;
+        end
+    endtask
+
+    // === FAST x86 ALU ===
+    task fast_x86_alu;
+        input [31:0] instr;
+        reg [64:0] sum;
+        begin
+            // Simplified x86 ALU for FAST operations
+            case (instr[15:8])
+                `X86_OP_MOV_IMM: begin // MOV immediate (flags unaffected)
+                    case (instr[18:16]) // ModR/M reg field
+                        3'b001: begin // RCX
+                            x86_regs[1] <= {32'h0, instr[31:16]};
+                            trace_write(`X86_REG_RCX, {32'h0, instr[31:16]});
+                        end
+                        default: begin // RAX
+                            x86_regs[0] <= {32'h0, instr[31:16]};
+                            trace_write(`X86_REG_RAX, {32'h0, instr[31:16]});
+                        end
+                    endcase
+                end
+
+                `X86_OP_MOV_AL_IMM: begin // MOV AL, imm8 (rest of RAX kept)
+                    x86_regs[0] <= {x86_regs[0][63:8], instr[23:16]};
+                    trace_write(`X86_REG_RAX, {x86_regs[0][63:8], instr[23:16]});
+                end
+
+                `X86_OP_ADD_REG: begin // ADD reg, reg
+                    sum = {1'b0, x86_regs[0]} + {1'b0, x86_regs[1]}; // RAX += RCX
+                    x86_regs[0] <= sum[63:0];
+                    trace_write(`X86_REG_RAX, sum[63:0]);
+                    set_x86_flags(sum[64], sum[63:0] == 0, sum[63],
+                                  (x86_regs[0][63] == x86_regs[1][63]) && (sum[63] != x86_regs[0][63]));
+                end
+            endcase
+        end
+    endtask
+
+    // ModRM of a MOVDQU memory form: [reg] without SIB or displacement
+    function sse_mem_modrm;
+        input [7:0] modrm;
+        sse_mem_modrm = modrm[7:6] == `X86_MOD_MEM && modrm[2:0] != 3'd4 && modrm[2:0] != 3'd5;
+    endfunction
+
+    // === FAST x86 FLAGS UPDATE ===
+    task set_x86_flags;
+        input cf, zf, sf, of;
+        begin
+            x86_cf <= cf;
+            x86_zf <= zf;
+            x86_sf <= sf;
+            x86_of <= of;
+
+            // Pack into RFLAGS at the architectural bit positions (IF and bit 1 stay set)
+            x86_rflags <= 64'h202 | ({63'h0, cf} << `X86_FLAG_CF) | ({63'h0, zf} << `X86_FLAG_ZF)
+                                  | ({63'h0, sf} << `X86_FLAG_SF) | ({63'h0, of} << `X86_FLAG_OF);
+        end
+    endtask
+
+endmodule
@@ -0,0 +1,317 @@
+// FAST Hybrid CPU - compact retired-instruction trace
+// Records come from the RTL retirement trace port (retire_*). Each record is
+// delta-encoded against the previous one, records are packed into 1 MiB chunks,
+// and a background thread zlib-compresses and writes full chunks while the
+// simulation fills the other buffer. Encoder state restarts at every chunk, so
+// chunks decode independently.
+//
+// File layout: TraceFileHeader, then { TraceChunkHeader, compressed payload }*
+// Record layout: flags byte (TRACE_FLAG_*), then
+//   zigzag varint pc delta   unless TRACE_FLAG_PC_NEXT (pc == previous pc + 4)
+//   4-byte instruction word  unless TRACE_FLAG_INSTR_CACHED (same word as last time at this pc)
+//   rd byte + zigzag varint delta to the last value written to rd   if TRACE_FLAG_WRITE
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+static const uint64_t TRACE_MAGIC = 0x4543415254425948ULL; // "HYBTRACE"
+static const uint32_t TRACE_VERSION = 1;
+static const size_t TRACE_CHUNK_BYTES = 1 << 20;
+static const size_t TRACE_MAX_RECORD_BYTES = 1 + 10 + 4 + 1 + 10;
+
+enum TraceFlags {
+    TRACE_FLAG_X86 = 0x01,
+    TRACE_FLAG_WRITE = 0x02,
+    TRACE_FLAG_INSTR_CACHED = 0x04,
+    TRACE_FLAG_PC_NEXT = 0x08
+};
+
+struct TraceRecord {
+    uint64_t pc;     // PC, or RIP for x86 records
+    uint32_t instr;
+    bool x86;
+    bool write;      // rd/value are valid
+    uint8_t rd;
+    uint64_t value;
+};
+
+struct TraceFileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t chunk_bytes;
+};
+
+struct TraceChunkHeader {
+    uint32_t raw_bytes;
+    uint32_t compressed_bytes;
+    uint32_t records;
+    uint32_t reserved;
+};
+
+// Prediction state shared by encoder and decoder
+class TraceCodecState {
+protected:
+    static const int INSTR_CACHE_SIZE = 1024;
+
+    uint64_t last_pc;
+    uint64_t last_value[48]; // 32 RISC-V registers, then 16 x86 registers
+    uint64_t cache_pc[INSTR_CACHE_SIZE];
+    uint32_t cache_instr[INSTR_CACHE_SIZE];
+
+    static int cache_index(uint64_t pc) { return static_cast<int>((pc ^ (pc >> 10)) & (INSTR_CACHE_SIZE - 1)); }
+    static int value_index(const TraceRecord& r) { return r.x86 ? 32 + (r.rd & 0xF) : (r.rd & 0x1F); }
+
+public:
+    TraceCodecState() { reset(); }
+
+    void reset() {
+        last_pc = 0;
+        memset(last_value, 0, sizeof(last_value));
+        memset(cache_pc, 0xFF, sizeof(cache_pc));
+        memset(cache_instr, 0, sizeof(cache_instr));
+    }
+};
+
+class TraceEncoder : public TraceCodecState {
+public:
+    // Encode one record into out (at least TRACE_MAX_RECORD_BYTES); returns its size
+    size_t encode(const TraceRecord& r, uint8_t* out) {
+        uint8_t* p = out + 1;
+        uint8_t flags = (r.x86 ? TRACE_FLAG_X86 : 0) | (r.write ? TRACE_FLAG_WRITE : 0);
+
+        if (r.pc == last_pc + 4) flags |= TRACE_FLAG_PC_NEXT;
+        else p = put_varint(p, zigzag(r.pc - last_pc));
+        last_pc = r.pc;
+
+        int slot = cache_index(r.pc);
+        if (cache_pc[slot] == r.pc && cache_instr[slot] == r.instr) {
+            flags |= TRACE_FLAG_INSTR_CACHED;
+        } else {
+            memcpy(p, &r.instr, 4);
+            p += 4;
+            cache_pc[slot] = r.pc;
+            cache_instr[slot] = r.instr;
+        }
+
+        if (r.write) {
+            *p++ = r.rd;
+            uint64_t& last = last_value[value_index(r)];
+            p = put_varint(p, zigzag(r.value - last));
+            last = r.value;
+        }
+
+        out[0] = flags;
+        return static_cast<size_t>(p - out);
+    }
+
+private:
+    static uint64_t zigzag(uint64_t delta) {
+        return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+    }
+
+    static uint8_t* put_varint(uint8_t* p, uint64_t v) {
+        while (v >= 0x80) {
+            *p++ = static_cast<uint8_t>(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = static_cast<uint8_t>(v);
+        return p;
+    }
+};
+
+class TraceDecoder : public TraceCodecState {
+public:
+    // Decode the record at p and advance past it; false on truncated input
+    bool decode(const uint8_t*& p, const uint8_t* end, TraceRecord& r) {
+        if (p >= end) return false;
+        uint8_t flags = *p++;
+        r.x86 = (flags & TRACE_FLAG_X86) != 0;
+        r.write = (flags & TRACE_FLAG_WRITE) != 0;
+
+        if (flags & TRACE_FLAG_PC_NEXT) {
+            r.pc = last_pc + 4;
+        } else {
+            uint64_t delta;
+            if (!get_varint(p, end, delta)) return false;
+            r.pc = last_pc + unzigzag(delta);
+        }
+        last_pc = r.pc;
+
+        int slot = cache_index(r.pc);
+        if (flags & TRACE_FLAG_INSTR_CACHED) {
+            r.instr = cache_instr[slot];
+        } else {
+            if (end - p < 4) return false;
+            memcpy(&r.instr, p, 4);
+            p += 4;
+            cache_pc[slot] = r.pc;
+            cache_instr[slot] = r.instr;
+        }
+
+        r.rd = 0;
+        r.value = 0;
+        if (r.write) {
+            uint64_t delta;
+            if (p >= end) return false;
+            r.rd = *p++;
+            if (!get_varint(p, end, delta)) return false;
+            uint64_t& last = last_value[value_index(r)];
+            r.value = last + unzigzag(delta);
+            last = r.value;
+        }
+        return true;
+    }
+
+private:
+    static uint64_t unzigzag(uint64_t v) { return (v >> 1) ^ (0 - (v & 1)); }
+
+    static bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t byte = *p++;
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+};
+
+// Double-buffered trace file writer. append() only encodes into memory; full
+// chunks are handed to a writer thread for compression and I/O. The producer
+// waits only if the writer is still busy with the previous chunk when the
+// next one fills up (counted in stalls()).
+class TraceWriter {
+private:
+    struct Chunk {
+        std::vector<uint8_t> data;
+        size_t used = 0;
+        uint32_t records = 0;
+    };
+
+    FILE* file;
+    Chunk chunks[2];
+    Chunk* active;      // Owned by the producer
+    Chunk* pending;     // Full chunk owned by the writer thread, or nullptr
+    TraceEncoder encoder;
+    std::vector<uint8_t> compressed;
+
+    std::thread writer;
+    std::mutex lock;
+    std::condition_variable changed;
+    bool stopping;
+
+    uint64_t total_records;
+    uint64_t raw_bytes;
+    uint64_t file_bytes;
+    uint64_t stall_count;
+    bool io_error;
+
+public:
+    TraceWriter() : file(nullptr), active(&chunks[0]), pending(nullptr), stopping(false),
+                    total_records(0), raw_bytes(0), file_bytes(0), stall_count(0), io_error(false) {}
+    ~TraceWriter() { close(); }
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    bool open(const char* path, std::string& error) {
+        file = fopen(path, "wb");
+        if (!file) {
+            error = std::string("cannot create trace ") + path;
+            return false;
+        }
+        TraceFileHeader header = {TRACE_MAGIC, TRACE_VERSION, static_cast<uint32_t>(TRACE_CHUNK_BYTES)};
+        fwrite(&header, sizeof(header), 1, file);
+        file_bytes = sizeof(header);
+
+        for (Chunk& c : chunks) c.data.resize(TRACE_CHUNK_BYTES);
+        compressed.resize(compressBound(TRACE_CHUNK_BYTES));
+        writer = std::thread(&TraceWriter::writer_loop, this);
+        return true;
+    }
+
+    void append(const TraceRecord& record) {
+        if (active->used + TRACE_MAX_RECORD_BYTES > active->data.size()) hand_off();
+        active->used += encoder.encode(record, active->data.data() + active->used);
+        active->records++;
+        total_records++;
+    }
+
+    // Flush the partial chunk, stop the writer thread and close the file.
+    // Returns false if any write failed.
+    bool close() {
+        if (!file) return !io_error;
+        if (active->records) hand_off();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        writer.join();
+        if (fclose(file) != 0) io_error = true;
+        file = nullptr;
+        return !io_error;
+    }
+
+    uint64_t records() const { return total_records; }
+    uint64_t uncompressed_bytes() const { return raw_bytes; }
+    uint64_t bytes_written() const { return file_bytes; }
+    uint64_t stalls() const { return stall_count; }
+
+private:
+    void hand_off() {
+        std::unique_lock<std::mutex> guard(lock);
+        if (pending) {
+            stall_count++;
+            changed.wait(guard, [this] { return pending == nullptr; });
+        }
+        pending = active;
+        active = (active == &chunks[0]) ? &chunks[1] : &chunks[0];
+        guard.unlock();
+        changed.notify_all();
+
+        active->used = 0;
+        active->records = 0;
+        encoder.reset();
+    }
+
+    void writer_loop() {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;) {
+            changed.wait(guard, [this] { return pending != nullptr || stopping; });
+            if (!pending) return; // Stopping with nothing left to write
+            Chunk* chunk = pending;
+            guard.unlock();
+
+            write_chunk(*chunk);
+
+            guard.lock();
+            pending = nullptr;
+            changed.notify_all();
+        }
+    }
+
+    void write_chunk(const Chunk& chunk) {
+        uLongf length = compressed.size();
+        if (compress2(compressed.data(), &length, chunk.data.data(), chunk.used, Z_BEST_SPEED) != Z_OK) {
+            io_error = true;
+            return;
+        }
+        TraceChunkHeader header = {static_cast<uint32_t>(chunk.used), static_cast<uint32_t>(length),
+                                   chunk.records, 0};
+        if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+            fwrite(compressed.data(), 1, length, file) != length) {
+            io_error = true;
+        }
+        raw_bytes += chunk.used;
+        file_bytes += sizeof(header) + length;
+    }
+};
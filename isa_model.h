@@ -0,0 +1,555 @@
+// FAST Hybrid CPU - functional ISA model
+// Plain C++ reference for the instruction subset the RTL implements. One step()
+// executes one instruction word on each enabled core. The model is not
+// cycle-accurate for the pipelined RISC-V core: it can run ahead of the RTL
+// (fast-forward) or next to it, stepped and checked on every RTL commit (lockstep).
+
+#pragma once
+
+#include "hybrid_model.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Architectural x86 RFLAGS bits driven by the RTL (X86_FLAG_* in x86_constants.vh)
+static const uint64_t X86_RFLAGS_RESET = 0x202; // IF plus the always-one bit 1
+static const uint64_t X86_RFLAGS_CF = 1ULL << 0;
+static const uint64_t X86_RFLAGS_ZF = 1ULL << 6;
+static const uint64_t X86_RFLAGS_SF = 1ULL << 7;
+static const uint64_t X86_RFLAGS_OF = 1ULL << 11;
+
+static const uint32_t RV_MODE_SWITCH_MAGIC = 0xDEADBEEF;
+static const uint32_t RV_WFI = 0x10500073;
+
+class HybridIsaModel {
+public:
+    uint64_t pc = 0;
+    uint64_t x86_rip = 0;
+    bool x86_mode = false;   // x86 core enabled
+    bool rv_active = true;   // RISC-V core enabled
+    bool concurrent = false; // Both cores run every cycle (boot_concurrent)
+    bool rv_idle = false;    // Parked in WFI (until reset)
+    bool x86_idle = false;   // Parked in HLT (until the next 0xDEADBEEF)
+    uint64_t regs[32] = {};
+    uint64_t x86_regs[16] = {};
+    uint64_t vregs[32][2] = {};  // RISC-V V registers, low half first
+    uint64_t vl = 0;
+    uint64_t vsew = 0;           // log2 of the element bytes
+    uint64_t xmm[X86_XMM_REGS][2] = {};
+    uint64_t x86_rflags = X86_RFLAGS_RESET;
+    uint64_t reg_out = 0;
+    GuestMemory memory; // Private copy of the guest address space
+    GuestConsole* console = nullptr; // Receives console output; null drops it
+    uint32_t last_instr = 0;
+    PerfCounters perf = {};
+
+    // Copy the full architectural state out of the RTL (after reset or a restore)
+    void load_from_rtl(VRV64GC_optimized* cpu) {
+        auto* root = cpu->rootp;
+        CpuState state = capture_state(cpu);
+        pc = state.pc;
+        x86_rip = state.x86_rip;
+        x86_mode = state.x86_mode;
+        rv_active = state.rv_active;
+        rv_idle = state.rv_idle;
+        x86_idle = state.x86_idle;
+        concurrent = root->RV64GC_optimized__DOT__boot_concurrent;
+        memcpy(regs, state.regs, sizeof(regs));
+        memcpy(x86_regs, state.x86_regs, sizeof(x86_regs));
+        memcpy(vregs, state.vregs, sizeof(vregs));
+        vl = state.vl;
+        vsew = state.vsew;
+        memcpy(xmm, state.xmm, sizeof(xmm));
+        x86_rflags = cpu->x86_rflags;
+        reg_out = cpu->reg_out;
+        if (GuestMemory* rtl_memory = attached_memory(cpu)) memory.copy_from(*rtl_memory);
+        last_instr = cpu->debug_instr;
+        perf = capture_counters(cpu);
+    }
+
+    // Hand the model state to the RTL. Reset applies PC/RIP/RFLAGS and the
+    // core enables through the boot registers, clears reg_out and the counters,
+    // so both sides restart counting from the hand-off point. Reset also wakes
+    // both cores, so a core the model left in WFI/HLT is parked again after it.
+    void store_to_rtl(VRV64GC_optimized* cpu) {
+        auto* root = cpu->rootp;
+        for (int i = 0; i < 32; i++) rtl_regs(cpu)[i] = regs[i];
+        for (int i = 0; i < 16; i++) rtl_x86_regs(cpu)[i] = x86_regs[i];
+        for (int i = 0; i < 32; i++) u64_to_wide(vregs[i], rtl_vregs(cpu)[i]);
+        rtl_vl(cpu) = vl;
+        rtl_vsew(cpu) = vsew;
+        for (int i = 0; i < X86_XMM_REGS; i++) u64_to_wide(xmm[i], rtl_xmm(cpu)[i]);
+        if (GuestMemory* rtl_memory = attached_memory(cpu)) rtl_memory->copy_from(memory);
+        root->RV64GC_optimized__DOT__boot_pc = pc;
+        root->RV64GC_optimized__DOT__boot_rip = x86_rip;
+        root->RV64GC_optimized__DOT__boot_rflags = x86_rflags;
+        root->RV64GC_optimized__DOT__boot_x86_mode = x86_mode;
+        root->RV64GC_optimized__DOT__boot_concurrent = concurrent;
+        reset_cpu(cpu);
+        rtl_rv_idle(cpu) = rv_idle;
+        rtl_x86_idle(cpu) = x86_idle;
+        cpu->eval();
+        reg_out = 0;
+        perf = capture_counters(cpu);
+    }
+
+    // Execute one instruction (retired or skipped) on each enabled core
+    void step() {
+        step(rv_active, x86_mode);
+    }
+
+    // Step only the given cores, in RTL commit order (RISC-V first); lockstep
+    // uses this to follow the cycles in which each RTL core committed
+    void step(bool rv_run, bool x86_run) {
+        start_x86 = false;
+
+        perf.mcycle++;
+        if (rv_run) {
+            perf.rv_mcycle++;
+            if (rv_idle) perf.rv_idle_cycles++;
+            else step_riscv();
+        }
+        if (x86_run) {
+            perf.x86_mcycle++;
+            if (x86_idle) perf.x86_idle_cycles++;
+            else step_x86();
+        }
+
+        // 0xDEADBEEF (re)starts the x86 core, waking it from HLT; in handoff
+        // mode the RISC-V core parks
+        if (start_x86) {
+            x86_mode = true;
+            x86_idle = false;
+            x86_rip = start_x86_rip;
+            if (!concurrent) rv_active = false;
+        }
+    }
+
+    void run(uint64_t steps) {
+        for (uint64_t i = 0; i < steps; i++) step();
+    }
+
+private:
+    bool start_x86 = false;
+    uint64_t start_x86_rip = 0;
+
+    void retire(int perf_class) {
+        perf.minstret++;
+        if (perf_class >= PERF_CLASS_X86_ALU) perf.x86_minstret++;
+        else perf.rv_minstret++;
+        perf.class_retired[perf_class]++;
+    }
+
+    void step_riscv() {
+        uint32_t instr = memory.read32(pc & ~3ULL, GUEST_PORT_RV_FETCH);
+        last_instr = instr;
+        uint64_t next_pc = pc + 4;
+
+        if (instr == RV_MODE_SWITCH_MAGIC) {
+            retire(PERF_CLASS_RV_SYSTEM);
+            perf.mode_switches++;
+            start_x86 = true;
+            start_x86_rip = pc + 4;
+            pc = next_pc;
+            return;
+        }
+        if (instr == RV_WFI) { // No interrupt sources: parked until reset
+            retire(PERF_CLASS_RV_SYSTEM);
+            rv_idle = true;
+            pc = next_pc;
+            return;
+        }
+
+        uint32_t rd = (instr >> 7) & 0x1F;
+        uint32_t funct3 = (instr >> 12) & 0x7;
+        uint32_t funct7 = instr >> 25;
+        uint64_t a = regs[(instr >> 15) & 0x1F];
+        uint64_t b = regs[(instr >> 20) & 0x1F];
+        uint64_t imm_i = sext(instr >> 20, 12);
+        int perf_class = -1; // Unknown: skipped
+        bool writes_rd = true;
+        uint64_t result = 0;
+
+        switch (instr & 0x7F) {
+            case 0x13: // OP-IMM
+                result = alu64(funct3, false, instr & (1u << 30), false, a, imm_i);
+                perf_class = PERF_CLASS_RV_ALU_IMM;
+                break;
+            case 0x1B: // OP-IMM-32
+                if (!is_word_funct3(funct3)) break;
+                result = alu32(funct3, false, instr & (1u << 30), false, a, imm_i);
+                perf_class = PERF_CLASS_RV_ALU_IMM;
+                break;
+            case 0x33: // OP
+                if (!is_reg_funct(funct7, funct3)) break;
+                result = alu64(funct3, instr & (1u << 30), instr & (1u << 30), funct7 == 0x01, a, b);
+                perf_class = funct7 == 0x01 ? PERF_CLASS_RV_MULDIV : PERF_CLASS_RV_ALU_REG;
+                break;
+            case 0x3B: // OP-32
+                if (!is_reg_funct(funct7, funct3) || (funct7 != 0x01 && !is_word_funct3(funct3))) break;
+                result = alu32(funct3, instr & (1u << 30), instr & (1u << 30), funct7 == 0x01, a, b);
+                perf_class = funct7 == 0x01 ? PERF_CLASS_RV_MULDIV : PERF_CLASS_RV_ALU_REG;
+                break;
+            case 0x37: // LUI
+                result = sext(instr & 0xFFFFF000u, 32);
+                perf_class = PERF_CLASS_RV_ALU_IMM;
+                break;
+            case 0x17: // AUIPC
+                result = pc + sext(instr & 0xFFFFF000u, 32);
+                perf_class = PERF_CLASS_RV_ALU_IMM;
+                break;
+            case 0x6F: // JAL
+                result = pc + 4;
+                next_pc = pc + sext(((instr >> 31) << 20) | (((instr >> 12) & 0xFF) << 12) |
+                                    (((instr >> 20) & 0x1) << 11) | (((instr >> 21) & 0x3FF) << 1), 21);
+                perf_class = PERF_CLASS_RV_JUMP;
+                break;
+            case 0x67: // JALR
+                result = pc + 4;
+                next_pc = (a + imm_i) & ~1ULL;
+                perf_class = PERF_CLASS_RV_JUMP;
+                break;
+            case 0x63: { // BRANCH
+                if ((funct3 & 0x6) == 0x2) break; // funct3 2 and 3 are reserved
+                bool taken = false;
+                switch (funct3) {
+                    case 0: taken = a == b; break;
+                    case 1: taken = a != b; break;
+                    case 4: taken = static_cast<int64_t>(a) < static_cast<int64_t>(b); break;
+                    case 5: taken = static_cast<int64_t>(a) >= static_cast<int64_t>(b); break;
+                    case 6: taken = a < b; break;
+                    default: taken = a >= b; break;
+                }
+                if (taken) {
+                    next_pc = pc + sext(((instr >> 31) << 12) | (((instr >> 7) & 0x1) << 11) |
+                                        (((instr >> 25) & 0x3F) << 5) | (((instr >> 8) & 0xF) << 1), 13);
+                }
+                writes_rd = false;
+                perf_class = PERF_CLASS_RV_BRANCH;
+                break;
+            }
+            case 0x03: { // LOAD
+                if (funct3 == 7) break;
+                uint64_t data = load64(a + imm_i);
+                unsigned bits = 8u << (funct3 & 0x3);
+                result = bits == 64 ? data : (funct3 & 0x4) ? data & ((1ULL << bits) - 1) : sext(data, bits);
+                perf_class = PERF_CLASS_RV_LOAD;
+                break;
+            }
+            case 0x23: { // STORE
+                if (funct3 & 0x4) break;
+                uint64_t addr = a + sext(((instr >> 25) << 5) | ((instr >> 7) & 0x1F), 12);
+                store(addr, b, 1u << funct3);
+                writes_rd = false;
+                perf_class = PERF_CLASS_RV_STORE;
+                break;
+            }
+            case 0x57: // OP-V
+                if (funct3 == 7 && !(instr >> 31)) { // vsetvli
+                    result = vsetvli(instr, a);
+                    perf_class = PERF_CLASS_RV_ALU_IMM;
+                } else if (is_vector_arith(instr)) {
+                    vector_arith(instr, a);
+                    writes_rd = false;
+                    perf_class = (instr >> 26) == RV_FUNCT6_VMUL ? PERF_CLASS_RV_MULDIV : PERF_CLASS_RV_ALU_REG;
+                }
+                break;
+            case 0x07: // LOAD-FP: vle only
+            case 0x27: // STORE-FP: vse only
+                if (!is_vector_mem(instr)) break;
+                vector_mem(instr, a, (instr & 0x7F) == 0x27);
+                writes_rd = false;
+                perf_class = (instr & 0x7F) == 0x27 ? PERF_CLASS_RV_STORE : PERF_CLASS_RV_LOAD;
+                break;
+            default:
+                break;
+        }
+
+        if (perf_class < 0) {
+            perf.unknown_skips++;
+            pc += 4;
+            return;
+        }
+        if (writes_rd && rd != 0) { // x0 is hardwired to zero
+            regs[rd] = result;
+            reg_out = result;
+        }
+        retire(perf_class);
+        pc = next_pc;
+    }
+
+    static uint64_t sext(uint64_t value, unsigned bits) {
+        uint64_t sign = 1ULL << (bits - 1);
+        value &= (sign << 1) - 1;
+        return (value ^ sign) - sign;
+    }
+
+    static bool is_word_funct3(uint32_t funct3) {
+        return funct3 == 0 || funct3 == 1 || funct3 == 5;
+    }
+
+    // Mirrors is_reg_funct in hybrid_rv_core.v
+    static bool is_reg_funct(uint32_t funct7, uint32_t funct3) {
+        return funct7 == 0x00 || funct7 == 0x01 || (funct7 == 0x20 && (funct3 == 0 || funct3 == 5));
+    }
+
+    // Mirrors alu64 in hybrid_rv_core.v (only MUL of RV64M; the rest pass rs1 through)
+    static uint64_t alu64(uint32_t funct3, bool sub, bool sra, bool mul, uint64_t a, uint64_t b) {
+        if (mul) return funct3 == 0 ? a * b : a;
+        switch (funct3) {
+            case 0: return sub ? a - b : a + b;
+            case 1: return a << (b & 0x3F);
+            case 2: return static_cast<int64_t>(a) < static_cast<int64_t>(b);
+            case 3: return a < b;
+            case 4: return a ^ b;
+            case 5: return sra ? static_cast<uint64_t>(static_cast<int64_t>(a) >> (b & 0x3F)) : a >> (b & 0x3F);
+            case 6: return a | b;
+            default: return a & b;
+        }
+    }
+
+    // Mirrors alu32: *W operations (only MULW of RV64M)
+    static uint64_t alu32(uint32_t funct3, bool sub, bool sra, bool mul, uint64_t a, uint64_t b) {
+        if (mul && funct3 != 0) return a;
+        uint32_t x = static_cast<uint32_t>(a);
+        uint32_t y = static_cast<uint32_t>(b);
+        uint32_t result;
+        if (funct3 == 1) result = x << (y & 0x1F);
+        else if (funct3 == 5) result = sra ? static_cast<uint32_t>(static_cast<int32_t>(x) >> (y & 0x1F)) : x >> (y & 0x1F);
+        else result = mul ? x * y : sub ? x - y : x + y;
+        return sext(result, 32);
+    }
+
+    // === RISC-V V subset (mirrors the vector path of hybrid_rv_core.v) ===
+    static const uint32_t RV_FUNCT6_VADD = 0x00;
+    static const uint32_t RV_FUNCT6_VMUL = 0x25;
+
+    // Unmasked vadd.vv/.vx (OPIVV/OPIVX) and vmul.vv/.vx (OPMVV/OPMVX)
+    static bool is_vector_arith(uint32_t instr) {
+        uint32_t funct3 = (instr >> 12) & 0x7;
+        uint32_t funct6 = instr >> 26;
+        if (!(instr & (1u << 25))) return false;
+        return (funct6 == RV_FUNCT6_VADD && (funct3 == 0 || funct3 == 4)) ||
+               (funct6 == RV_FUNCT6_VMUL && (funct3 == 2 || funct3 == 6));
+    }
+
+    // Unit-stride, unmasked, single-field vle/vse of 8/16/32/64-bit elements
+    static bool is_vector_mem(uint32_t instr) {
+        uint32_t width = (instr >> 12) & 0x7;
+        return (instr >> 25) == 0x01 && ((instr >> 20) & 0x1F) == 0 &&
+               (width == 0 || width == 5 || width == 6 || width == 7);
+    }
+
+    // vl = min(AVL, VLMAX); only LMUL = 1 and SEW <= 64 are legal (else vl = 0)
+    uint64_t vsetvli(uint32_t instr, uint64_t avl) {
+        uint32_t rd = (instr >> 7) & 0x1F;
+        uint32_t rs1 = (instr >> 15) & 0x1F;
+        uint64_t vlmax = VEC_VLENB >> ((instr >> 23) & 0x3);
+        bool vill = ((instr >> 20) & 0x7) || (instr & (1u << 25)) || ((instr >> 28) & 0x7);
+        if (vill) vl = 0;
+        else if (rs1 != 0) vl = std::min(avl, vlmax);
+        else if (rd != 0) vl = vlmax;
+        else vl = std::min(vl, vlmax);
+        vsew = (instr >> 23) & 0x3;
+        return vl;
+    }
+
+    // vd = vs2 op (vs1 | x[rs1]) on the first vl elements; the tail keeps vd
+    void vector_arith(uint32_t instr, uint64_t scalar) {
+        uint8_t a[VEC_VLENB], b[VEC_VLENB], result[VEC_VLENB];
+        unsigned ebytes = 1u << vsew;
+        bool vx = instr & (1u << 14);
+        bool mul = (instr >> 26) == RV_FUNCT6_VMUL;
+        memcpy(a, vregs[(instr >> 20) & 0x1F], VEC_VLENB);
+        if (vx) {
+            for (int i = 0; i < VEC_VLENB; i += ebytes) memcpy(b + i, &scalar, ebytes);
+        } else {
+            memcpy(b, vregs[(instr >> 15) & 0x1F], VEC_VLENB);
+        }
+        simd_alu(mul, ebytes, a, b, result);
+
+        uint8_t* vd = reinterpret_cast<uint8_t*>(vregs[(instr >> 7) & 0x1F]);
+        unsigned active = vl * ebytes;
+        memcpy(vd, result, active);
+        simd_retire(perf.rv_simd_ops, perf.rv_simd_elements, active, vl);
+    }
+
+    // vle/vse: the first min(vl, VLMAX(eew)) elements in one access
+    void vector_mem(uint32_t instr, uint64_t addr, bool is_store) {
+        uint32_t width = (instr >> 12) & 0x7;
+        unsigned ebytes = width == 0 ? 1 : 1u << (width - 4);
+        uint64_t elements = std::min<uint64_t>(vl, VEC_VLENB / ebytes);
+        unsigned active = elements * ebytes;
+        uint64_t* vd = vregs[(instr >> 7) & 0x1F];
+        if (active && is_store) {
+            store128(addr, vd, active);
+        } else if (active) {
+            uint64_t data[2];
+            load128(addr, data);
+            memcpy(vd, data, active);
+        }
+        simd_retire(perf.rv_simd_ops, perf.rv_simd_elements, active, elements);
+    }
+
+    // Mirrors hybrid_simd_alu.v: wrapping add or low half of the product per element
+    static void simd_alu(bool mul, unsigned ebytes, const uint8_t* a, const uint8_t* b, uint8_t* result) {
+        for (int i = 0; i < VEC_VLENB; i += ebytes) {
+            uint64_t x = 0, y = 0;
+            memcpy(&x, a + i, ebytes);
+            memcpy(&y, b + i, ebytes);
+            uint64_t r = mul ? x * y : x + y;
+            memcpy(result + i, &r, ebytes);
+        }
+    }
+
+    // A lane counts when any of its bytes was active (active bytes start at byte 0)
+    void simd_retire(uint64_t& ops, uint64_t& elements, unsigned active_bytes, uint64_t element_count) {
+        ops++;
+        elements += element_count;
+        for (int lane = 0; lane < VEC_LANES; lane++) {
+            if (active_bytes > static_cast<unsigned>(lane) * (VEC_VLENB / VEC_LANES)) perf.simd_lane_active[lane]++;
+        }
+    }
+
+    // Wide data-port access: two 8-byte halves. On the console page only the
+    // low half reaches the UART, like the arbiter's MMIO decode.
+    void load128(uint64_t addr, uint64_t out[2]) {
+        out[0] = load64(addr);
+        out[1] = is_console(addr) ? 0 : load64(addr + 8);
+    }
+
+    void store128(uint64_t addr, const uint64_t value[2], unsigned bytes) {
+        store(addr, value[0], std::min(bytes, 8u));
+        if (bytes > 8 && !is_console(addr)) store(addr + 8, value[1], bytes - 8);
+    }
+
+    static bool is_console(uint64_t addr) {
+        return (addr & ~0xFFFULL) == CONSOLE_BASE;
+    }
+
+    // 8 little-endian bytes, like the arbiter's data port. The model's UART
+    // drains instantly, so LSR always reads idle; the RTL FIFO shows a byte
+    // in flight for TX_CYCLES after each write.
+    uint64_t load64(uint64_t addr) {
+        if (is_console(addr)) return (addr & 0x7) == CONSOLE_REG_LSR ? CONSOLE_LSR_IDLE : 0;
+        return memory.read64(addr, GUEST_PORT_DATA);
+    }
+
+    void store(uint64_t addr, uint64_t value, unsigned bytes) {
+        if (!is_console(addr)) {
+            memory.write(addr, value, bytes, GUEST_PORT_DATA);
+        } else if ((addr & 0x7) == CONSOLE_REG_THR && console) {
+            console->put(static_cast<uint8_t>(value));
+        }
+    }
+
+    void step_x86() {
+        uint32_t instr = memory.read32(x86_rip & ~3ULL, GUEST_PORT_X86_FETCH);
+        last_instr = instr;
+
+        switch (instr & 0xFF) {
+            case 0x48: // REX.W, fixed 4-byte encoding
+                x86_alu(instr);
+                retire(((instr >> 8) & 0xFF) == 0xE6 ? PERF_CLASS_X86_IO : PERF_CLASS_X86_ALU);
+                x86_rip += 4;
+                break;
+            case 0x90:
+                retire(PERF_CLASS_X86_NOP);
+                x86_rip += 1;
+                break;
+            case 0xF4: // HLT: parked until the next start
+                retire(PERF_CLASS_X86_HALT);
+                x86_rip += 1;
+                x86_idle = true;
+                break;
+            case 0x66: // SSE2 packed integer
+            case 0xF3: // MOVDQU
+                if (x86_sse(instr)) break;
+                perf.unknown_skips++;
+                x86_rip += 1;
+                break;
+            default:
+                perf.unknown_skips++;
+                x86_rip += 1;
+                break;
+        }
+    }
+
+    // Mirrors the SSE subset of hybrid_x86_core.v; false = not decoded (skipped)
+    bool x86_sse(uint32_t instr) {
+        uint32_t prefix = instr & 0xFF;
+        uint32_t opcode = (instr >> 16) & 0xFF;
+        uint32_t modrm = instr >> 24;
+        if (((instr >> 8) & 0xFF) != 0x0F) return false;
+
+        if (prefix == 0x66 && opcode == 0x38 && modrm == 0x40) {
+            // PMULLD: 66 0F 38 40, then a word holding ModRM and NOP padding
+            uint32_t modrm2 = memory.read32((x86_rip + 4) & ~3ULL, GUEST_PORT_X86_FETCH) & 0xFF;
+            uint64_t* dst = xmm[(modrm2 >> 3) & 0x7];
+            uint8_t result[VEC_VLENB];
+            simd_alu(true, 4, reinterpret_cast<uint8_t*>(dst), reinterpret_cast<uint8_t*>(xmm[modrm2 & 0x7]), result);
+            memcpy(dst, result, VEC_VLENB);
+            x86_sse_retire(4);
+            x86_rip += 8;
+            return true;
+        }
+
+        uint32_t mod = modrm >> 6;
+        uint64_t* reg = xmm[(modrm >> 3) & 0x7];
+        uint64_t* rm = xmm[modrm & 0x7];
+        if (prefix == 0x66 && opcode == 0xD4 && mod == 3) { // PADDQ xmm, xmm
+            reg[0] += rm[0];
+            reg[1] += rm[1];
+            x86_sse_retire(2);
+        } else if (prefix == 0xF3 && (opcode == 0x6F || opcode == 0x7F)) { // MOVDQU
+            bool mem = mod == 0 && (modrm & 0x7) != 4 && (modrm & 0x7) != 5;
+            if (mod != 3 && !mem) return false;
+            uint64_t addr = x86_regs[modrm & 0x7];
+            if (opcode == 0x6F && mem) load128(addr, reg);
+            else if (opcode == 0x6F) memcpy(reg, rm, VEC_VLENB);
+            else if (mem) store128(addr, reg, VEC_VLENB);
+            else memcpy(rm, reg, VEC_VLENB);
+            x86_sse_retire(VEC_VLENB);
+        } else {
+            return false;
+        }
+        x86_rip += 4;
+        return true;
+    }
+
+    void x86_sse_retire(uint64_t elements) {
+        retire(PERF_CLASS_X86_SIMD);
+        simd_retire(perf.x86_simd_ops, perf.x86_simd_elements, VEC_VLENB, elements);
+    }
+
+    void x86_alu(uint32_t instr) {
+        switch ((instr >> 8) & 0xFF) {
+            case 0xC7: { // MOV r, imm16 (zero-extended); only RAX and RCX decode
+                int reg = ((instr >> 16) & 0x7) == 1 ? 1 : 0;
+                x86_regs[reg] = instr >> 16;
+                break;
+            }
+            case 0xB0: // MOV AL, imm8
+                x86_regs[0] = (x86_regs[0] & ~0xFFULL) | ((instr >> 16) & 0xFF);
+                break;
+            case 0xE6: // OUT imm8, AL: port = console register offset
+                store(CONSOLE_BASE + ((instr >> 16) & 0xFF), x86_regs[0] & 0xFF, 1);
+                break;
+            case 0x01: { // ADD RAX, RCX
+                uint64_t a = x86_regs[0];
+                uint64_t b = x86_regs[1];
+                uint64_t sum = a + b;
+                bool of = ((a >> 63) == (b >> 63)) && ((sum >> 63) != (a >> 63));
+                x86_regs[0] = sum;
+                x86_rflags = X86_RFLAGS_RESET
+                    | (sum < a ? X86_RFLAGS_CF : 0)
+                    | (sum == 0 ? X86_RFLAGS_ZF : 0)
+                    | ((sum >> 63) ? X86_RFLAGS_SF : 0)
+                    | (of ? X86_RFLAGS_OF : 0);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+};
@@ -0,0 +1,55 @@
+// FAST Hybrid CPU - read-only file mapping
+// Shared by the program loader and the offline trace tools; no model dependency.
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mapping of a whole file, unmapped on destruction
+class MappedFile {
+private:
+    const uint8_t* data;
+    size_t length;
+
+public:
+    MappedFile() : data(nullptr), length(0) {}
+    ~MappedFile() {
+        if (data) munmap(const_cast<uint8_t*>(data), length);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path, std::string& error) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            error = std::string("cannot open ") + path + ": " + strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            error = std::string("cannot stat or empty file: ") + path;
+            close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(st.st_size);
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            error = std::string("mmap failed for ") + path + ": " + strerror(errno);
+            length = 0;
+            return false;
+        }
+        data = static_cast<const uint8_t*>(p);
+        return true;
+    }
+
+    const uint8_t* bytes() const { return data; }
+    size_t size() const { return length; }
+};
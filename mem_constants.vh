@@ -0,0 +1,31 @@
+// FAST Memory System Constants
+// L1 cache, backing memory and MMIO configuration shared by the memory arbiter
+// and the top level
+
+// Replacement policies (hybrid_cache REPLACEMENT parameter)
+`define CACHE_REPL_LRU    0  // True LRU (per-way age ranks)
+`define CACHE_REPL_FIFO   1  // Evict in fill order
+`define CACHE_REPL_RANDOM 2  // 16-bit LFSR
+
+// Default geometry: small, so even toy guests see capacity and conflict misses
+`define L1_DEFAULT_SIZE         256
+`define L1_DEFAULT_WAYS         2
+`define L1_DEFAULT_LINE         32
+`define MEM_DEFAULT_MISS_LATENCY 4  // Backing memory cycles per line refill
+
+// Backing memory access ports (GuestMemPort in guest_memory.h); each has its
+// own software TLB in the harness
+`define MEM_PORT_RV_FETCH  0
+`define MEM_PORT_X86_FETCH 1
+`define MEM_PORT_DATA      2
+
+// Console UART (hybrid_uart.v): one uncached 4 KiB MMIO page on the data port.
+// Register offsets follow the 16550, so polling THR/LSR drivers work unchanged;
+// x86 OUT imm8 reaches the same registers at port = offset.
+`define CONSOLE_BASE        64'h0000_0000_1000_0000
+`define CONSOLE_REG_THR     3'd0  // Write: push a byte into the TX FIFO
+`define CONSOLE_REG_LSR     3'd5  // Read: line status
+`define CONSOLE_LSR_THRE    5     // TX FIFO has room
+`define CONSOLE_LSR_TEMT    6     // TX FIFO empty
+`define CONSOLE_FIFO_DEPTH  16
+`define CONSOLE_DEFAULT_TX_CYCLES 1  // Cycles per byte drained to the host
@@ -0,0 +1,330 @@
+// FAST Hybrid CPU - sampling guest PC profiler
+// Every `period` cycles the architectural PC of each running core (pc for
+// RISC-V, x86_rip for x86) is counted in a fixed open-addressed histogram that
+// is allocated once up front. Simulation runs in period-sized run_cycles()
+// chunks between samples, so the per-cycle loop is untouched; the cost is one
+// hash update per sample.
+//
+// Reports are symbolized from the ELF .symtab of the loaded guest, when there
+// is one: a flat per-function profile, and folded stacks ("isa;function;pc
+// count" lines) for flamegraph.pl / speedscope. The RTL exposes no call stack,
+// so a stack is the ISA, the enclosing function and the sampled instruction.
+
+#pragma once
+
+#include "hybrid_model.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <elf.h>
+#include <string>
+#include <vector>
+
+static const uint64_t PROFILE_DEFAULT_PERIOD = 1009; // Prime, so loops don't alias with the sampler
+static const size_t PROFILE_SLOTS = 1 << 14;         // Distinct (isa, pc) pairs kept
+static const int PROFILE_MAX_PROBE = 32;             // Beyond this a sample counts as dropped
+static const int PROFILE_TOP_ROWS = 8;
+static const size_t PROFILE_NAME_BYTES = 40;
+
+// Function symbols of a guest ELF, sorted by address
+class SymbolTable {
+private:
+    struct Symbol {
+        uint64_t addr;
+        uint64_t size; // 0 = extends to the next symbol
+        std::string name;
+    };
+    std::vector<Symbol> symbols;
+
+public:
+    // Non-ELF images and stripped ELFs load successfully with no symbols
+    bool load(const char* path, std::string& error) {
+        symbols.clear();
+        MappedFile file;
+        if (!file.open(path, error)) return false;
+
+        const uint8_t* base = file.bytes();
+        if (file.size() < sizeof(Elf64_Ehdr) || memcmp(base, ELFMAG, SELFMAG) != 0 ||
+            base[EI_CLASS] != ELFCLASS64) {
+            return true;
+        }
+        Elf64_Ehdr ehdr;
+        memcpy(&ehdr, base, sizeof(ehdr));
+        if (ehdr.e_shoff + static_cast<uint64_t>(ehdr.e_shnum) * sizeof(Elf64_Shdr) > file.size()) {
+            error = "truncated ELF section header table";
+            return false;
+        }
+
+        for (unsigned i = 0; i < ehdr.e_shnum; i++) {
+            Elf64_Shdr shdr;
+            memcpy(&shdr, base + ehdr.e_shoff + i * sizeof(Elf64_Shdr), sizeof(shdr));
+            if (shdr.sh_type != SHT_SYMTAB || shdr.sh_link >= ehdr.e_shnum) continue;
+
+            Elf64_Shdr strtab;
+            memcpy(&strtab, base + ehdr.e_shoff + shdr.sh_link * sizeof(Elf64_Shdr), sizeof(strtab));
+            if (shdr.sh_offset + shdr.sh_size > file.size() || strtab.sh_offset + strtab.sh_size > file.size()) {
+                error = "ELF symbol table exceeds file size";
+                return false;
+            }
+            const char* names = reinterpret_cast<const char*>(base + strtab.sh_offset);
+
+            for (uint64_t off = 0; off + sizeof(Elf64_Sym) <= shdr.sh_size; off += sizeof(Elf64_Sym)) {
+                Elf64_Sym sym;
+                memcpy(&sym, base + shdr.sh_offset + off, sizeof(sym));
+                if (ELF64_ST_TYPE(sym.st_info) != STT_FUNC || sym.st_shndx == SHN_UNDEF) continue;
+                if (sym.st_name >= strtab.sh_size) continue;
+                symbols.push_back({sym.st_value, sym.st_size,
+                                   std::string(names + sym.st_name, strnlen(names + sym.st_name, strtab.sh_size - sym.st_name))});
+            }
+        }
+
+        std::sort(symbols.begin(), symbols.end(),
+                  [](const Symbol& a, const Symbol& b) { return a.addr < b.addr; });
+        return true;
+    }
+
+    size_t size() const { return symbols.size(); }
+    const std::string& name(int index) const { return symbols[index].name; }
+    uint64_t address(int index) const { return symbols[index].addr; }
+
+    // Index of the function containing addr, or -1
+    int find(uint64_t addr) const {
+        auto it = std::upper_bound(symbols.begin(), symbols.end(), addr,
+                                   [](uint64_t a, const Symbol& s) { return a < s.addr; });
+        if (it == symbols.begin()) return -1;
+        --it;
+        if (it->size && addr - it->addr >= it->size) return -1;
+        return static_cast<int>(it - symbols.begin());
+    }
+};
+
+// One line of the live "top functions" panel (fixed size, safe to snapshot)
+struct ProfileTopEntry {
+    char name[PROFILE_NAME_BYTES];
+    bool x86;
+    uint64_t samples;
+};
+
+struct ProfileTop {
+    uint64_t total_samples;
+    uint64_t period;
+    int rows;
+    ProfileTopEntry entries[PROFILE_TOP_ROWS];
+};
+
+class PcProfiler {
+private:
+    struct Slot {
+        uint64_t pc;
+        uint64_t count; // 0 = empty slot
+        bool x86;
+    };
+
+    // A function (symbol index) or, for unsymbolized code, a single pc
+    struct Row {
+        bool x86;
+        bool symbolized;
+        uint64_t key;
+        uint64_t samples;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<Row> rows; // Scratch for reports, reserved once
+    const SymbolTable* symbols;
+    uint64_t period;
+    uint64_t countdown;
+    uint64_t total;
+    uint64_t dropped;
+
+public:
+    explicit PcProfiler(uint64_t sample_period = PROFILE_DEFAULT_PERIOD, const SymbolTable* symbol_table = nullptr)
+        : slots(PROFILE_SLOTS), symbols(symbol_table), period(sample_period ? sample_period : 1),
+          countdown(period), total(0), dropped(0) {
+        rows.reserve(PROFILE_SLOTS);
+    }
+
+    uint64_t sample_period() const { return period; }
+    uint64_t samples() const { return total; }
+    uint64_t dropped_samples() const { return dropped; }
+
+    void clear() {
+        std::fill(slots.begin(), slots.end(), Slot{0, 0, false});
+        countdown = period;
+        total = 0;
+        dropped = 0;
+    }
+
+    // Drop-in for run_cycles(): same simulation, plus a sample every period cycles
+    void run(VRV64GC_optimized* cpu, uint64_t cycles) {
+        run(cpu, cycles, [cpu](uint64_t n) { run_cycles(cpu, n); });
+    }
+
+    // Same, with a caller-supplied way of advancing n cycles (e.g. traced)
+    template <typename Advance>
+    void run(VRV64GC_optimized* cpu, uint64_t cycles, Advance advance) {
+        while (cycles) {
+            uint64_t n = std::min(cycles, countdown);
+            advance(n);
+            cycles -= n;
+            countdown -= n;
+            if (!countdown) {
+                sample(cpu);
+                countdown = period;
+            }
+        }
+    }
+
+    // Count the current PC of every running core
+    void sample(VRV64GC_optimized* cpu) {
+        auto* root = cpu->rootp;
+        if (root->RV64GC_optimized__DOT__rv_mode_active) record(cpu->pc, false);
+        if (root->RV64GC_optimized__DOT__x86_mode_active) record(cpu->x86_rip, true);
+    }
+
+    // Heaviest functions so far, for the live panel. Runs off the hot path.
+    void top(ProfileTop& out) {
+        aggregate_functions();
+        out.total_samples = total;
+        out.period = period;
+        out.rows = static_cast<int>(std::min<size_t>(rows.size(), PROFILE_TOP_ROWS));
+        for (int i = 0; i < out.rows; i++) {
+            const Row& row = rows[i];
+            snprintf(out.entries[i].name, sizeof(out.entries[i].name), "%s", row_name(row).c_str());
+            out.entries[i].x86 = row.x86;
+            out.entries[i].samples = row.samples;
+        }
+    }
+
+    // Flat profile: functions by samples, then the hottest instructions
+    bool write_flat(const char* path) {
+        FILE* out = fopen(path, "w");
+        if (!out) return false;
+
+        aggregate_functions();
+        fprintf(out, "# Flat profile: %" PRIu64 " samples, one every %" PRIu64 " cycles (%" PRIu64 " dropped)\n",
+                total, period, dropped);
+        fprintf(out, "#  samples       %%    cumul%%  isa    function\n");
+        uint64_t cumulative = 0;
+        for (const Row& row : rows) {
+            cumulative += row.samples;
+            fprintf(out, "%10" PRIu64 "  %6.2f  %7.2f  %-5s  %s\n", row.samples, percent(row.samples),
+                    percent(cumulative), isa_name(row.x86), row_name(row).c_str());
+        }
+
+        collect_pcs();
+        fprintf(out, "\n# Hot instructions\n#  samples       %%  isa    pc                  location\n");
+        for (size_t i = 0; i < rows.size() && i < 32; i++) {
+            const Row& row = rows[i];
+            fprintf(out, "%10" PRIu64 "  %6.2f  %-5s  0x%016" PRIx64 "  %s\n", row.samples, percent(row.samples),
+                    isa_name(row.x86), row.key, location(row.key).c_str());
+        }
+        fclose(out);
+        return true;
+    }
+
+    // Folded stacks, one "isa;function;location count" line per sampled pc
+    bool write_folded(const char* path) {
+        FILE* out = fopen(path, "w");
+        if (!out) return false;
+
+        collect_pcs();
+        for (const Row& row : rows) {
+            int sym = symbols ? symbols->find(row.key) : -1;
+            fprintf(out, "%s;%s;%s %" PRIu64 "\n", isa_name(row.x86),
+                    sym >= 0 ? symbols->name(sym).c_str() : "[unknown]", location(row.key).c_str(), row.samples);
+        }
+        fclose(out);
+        return true;
+    }
+
+    // <prefix>.profile.txt and <prefix>.folded
+    bool write_reports(const std::string& prefix) {
+        return write_flat((prefix + ".profile.txt").c_str()) && write_folded((prefix + ".folded").c_str());
+    }
+
+private:
+    void record(uint64_t pc, bool x86) {
+        total++;
+        uint64_t hash = (pc >> 1) * 0x9E3779B97F4A7C15ULL + x86;
+        size_t index = static_cast<size_t>(hash >> 50) & (PROFILE_SLOTS - 1);
+        for (int probe = 0; probe < PROFILE_MAX_PROBE; probe++) {
+            Slot& slot = slots[(index + probe) & (PROFILE_SLOTS - 1)];
+            if (slot.count && slot.pc == pc && slot.x86 == x86) {
+                slot.count++;
+                return;
+            }
+            if (!slot.count) {
+                slot = Slot{pc, 1, x86};
+                return;
+            }
+        }
+        dropped++;
+    }
+
+    // rows = one entry per sampled (isa, pc), heaviest first
+    void collect_pcs() {
+        rows.clear();
+        for (const Slot& slot : slots) {
+            if (slot.count) rows.push_back(Row{slot.x86, false, slot.pc, slot.count});
+        }
+        sort_by_samples();
+    }
+
+    // rows = pcs merged into their enclosing function, heaviest first
+    void aggregate_functions() {
+        rows.clear();
+        for (const Slot& slot : slots) {
+            if (!slot.count) continue;
+            int sym = symbols ? symbols->find(slot.pc) : -1;
+            rows.push_back(Row{slot.x86, sym >= 0, sym >= 0 ? static_cast<uint64_t>(sym) : slot.pc, slot.count});
+        }
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+            if (a.x86 != b.x86) return a.x86 < b.x86;
+            if (a.symbolized != b.symbolized) return a.symbolized < b.symbolized;
+            return a.key < b.key;
+        });
+        size_t merged = 0;
+        for (size_t i = 0; i < rows.size(); i++) {
+            if (merged && rows[merged - 1].x86 == rows[i].x86 && rows[merged - 1].symbolized &&
+                rows[i].symbolized && rows[merged - 1].key == rows[i].key) {
+                rows[merged - 1].samples += rows[i].samples;
+            } else {
+                rows[merged++] = rows[i];
+            }
+        }
+        rows.resize(merged);
+        sort_by_samples();
+    }
+
+    void sort_by_samples() {
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+            if (a.samples != b.samples) return a.samples > b.samples;
+            return a.key < b.key;
+        });
+    }
+
+    std::string row_name(const Row& row) const {
+        if (row.symbolized) return symbols->name(static_cast<int>(row.key));
+        char text[24];
+        snprintf(text, sizeof(text), "0x%" PRIx64, row.key);
+        return text;
+    }
+
+    // "function+0xoffset", or the bare address when no symbol covers it
+    std::string location(uint64_t pc) const {
+        char text[24];
+        int sym = symbols ? symbols->find(pc) : -1;
+        if (sym < 0) {
+            snprintf(text, sizeof(text), "0x%" PRIx64, pc);
+            return text;
+        }
+        snprintf(text, sizeof(text), "+0x%" PRIx64, pc - symbols->address(sym));
+        return symbols->name(sym) + text;
+    }
+
+    double percent(uint64_t n) const { return total ? 100.0 * n / total : 0; }
+    static const char* isa_name(bool x86) { return x86 ? "x86" : "riscv"; }
+};
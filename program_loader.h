@@ -0,0 +1,140 @@
+// FAST Hybrid CPU - guest program loader
+// Memory-maps an ELF64 or flat binary and copies it into the model's attached
+// sparse guest memory at its link addresses, then programs the boot PC/RIP and
+// ISA mode. Images of any size load; only the pages they cover are allocated.
+
+#pragma once
+
+#include "hybrid_model.h"
+#include "mapped_file.h"
+#include <cstdint>
+#include <cstring>
+#include <elf.h>
+#include <string>
+
+struct ProgramInfo {
+    uint64_t entry = 0;
+    bool x86_mode = false;
+    bool is_elf = false;
+    uint64_t bytes_loaded = 0;
+};
+
+// The original demo: five RISC-V ALU ops, 0xDEADBEEF, then x86 MOV/MOV/ADD/NOP,
+// padded with RISC-V NOPs to 128 words
+static const uint32_t BUILTIN_PROGRAM[] = {
+    0x00100093, // ADDI x1,x0,1
+    0x00200113, // ADDI x2,x0,2
+    0x002081b3, // ADD x3,x1,x2
+    0x0020c3b3, // XOR x7,x1,x2
+    0x022083b3, // MUL x7,x1,x2 (RV64M)
+    0xDEADBEEF, // MAGIC FAST SWITCH!
+    0x48C7C001, // MOV RAX, 1 (x86-64)
+    0x48C7C102, // MOV RCX, 2
+    0x004801C8, // ADD RAX, RCX
+    0x00000090, // NOP
+};
+static const unsigned BUILTIN_PROGRAM_WORDS = 128;
+
+// Write 32-bit words at addr (benchmark workloads, the built-in demo)
+inline void write_guest_words(GuestMemory& memory, uint64_t addr, const uint32_t* words, size_t count) {
+    for (size_t i = 0; i < count; i++) memory.write(addr + i * 4, words[i], 4);
+}
+
+inline bool load_elf(GuestMemory& memory, const MappedFile& file, ProgramInfo& info, std::string& error) {
+    const uint8_t* base = file.bytes();
+    if (file.size() < sizeof(Elf64_Ehdr) || base[EI_CLASS] != ELFCLASS64 || base[EI_DATA] != ELFDATA2LSB) {
+        error = "only little-endian ELF64 images are supported";
+        return false;
+    }
+
+    Elf64_Ehdr ehdr;
+    memcpy(&ehdr, base, sizeof(ehdr));
+    if (ehdr.e_machine == EM_RISCV) {
+        info.x86_mode = false;
+    } else if (ehdr.e_machine == EM_X86_64) {
+        info.x86_mode = true;
+    } else {
+        error = "unsupported ELF machine type " + std::to_string(ehdr.e_machine);
+        return false;
+    }
+    if (ehdr.e_phoff + static_cast<uint64_t>(ehdr.e_phnum) * sizeof(Elf64_Phdr) > file.size()) {
+        error = "truncated ELF program header table";
+        return false;
+    }
+
+    for (unsigned i = 0; i < ehdr.e_phnum; i++) {
+        Elf64_Phdr phdr;
+        memcpy(&phdr, base + ehdr.e_phoff + i * sizeof(Elf64_Phdr), sizeof(phdr));
+        if (phdr.p_type != PT_LOAD) continue;
+        if (phdr.p_offset + phdr.p_filesz > file.size() || phdr.p_filesz > phdr.p_memsz) {
+            error = "ELF segment " + std::to_string(i) + " exceeds file size";
+            return false;
+        }
+
+        // Code and data share one address space; .bss stays unallocated until written
+        memory.write_bytes(phdr.p_vaddr, base + phdr.p_offset, phdr.p_filesz);
+        if (phdr.p_memsz > phdr.p_filesz) {
+            memory.write_bytes(phdr.p_vaddr + phdr.p_filesz, nullptr, phdr.p_memsz - phdr.p_filesz);
+        }
+        info.bytes_loaded += phdr.p_memsz;
+    }
+
+    info.entry = ehdr.e_entry;
+    info.is_elf = true;
+    return true;
+}
+
+// Load the built-in demo into the attached memory and reset
+inline void load_builtin_program(VRV64GC_optimized* cpu) {
+    GuestMemory* memory = attached_memory(cpu);
+    if (memory) {
+        memory->clear();
+        uint32_t words[BUILTIN_PROGRAM_WORDS];
+        for (unsigned i = 0; i < BUILTIN_PROGRAM_WORDS; i++) words[i] = 0x00000013; // RISC-V NOP
+        memcpy(words, BUILTIN_PROGRAM, sizeof(BUILTIN_PROGRAM));
+        write_guest_words(*memory, 0, words, BUILTIN_PROGRAM_WORDS);
+    }
+    reset_cpu(cpu);
+}
+
+// Load a guest program into a freshly constructed model (with memory attached)
+// and reset it. ELF images pick their ISA from e_machine; flat binaries load at
+// address 0 and start in x86 mode only when raw_x86 is set.
+inline bool load_program(VRV64GC_optimized* cpu, const char* path, ProgramInfo& info,
+                         std::string& error, bool raw_x86 = false) {
+    GuestMemory* memory = attached_memory(cpu);
+    if (!memory) {
+        error = "no guest memory attached to the model";
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(path, error)) return false;
+
+    // Run the RTL initial blocks first so they cannot overwrite the boot registers
+    cpu->eval();
+
+    auto* root = cpu->rootp;
+    memory->clear();
+
+    info = ProgramInfo();
+    const uint8_t* base = file.bytes();
+    bool elf = file.size() >= SELFMAG && memcmp(base, ELFMAG, SELFMAG) == 0;
+    if (elf) {
+        if (!load_elf(*memory, file, info, error)) return false;
+    } else {
+        memory->write_bytes(0, base, file.size());
+        info.bytes_loaded = file.size();
+        info.entry = 0;
+        info.x86_mode = raw_x86;
+    }
+
+    if (info.x86_mode) {
+        root->RV64GC_optimized__DOT__boot_rip = info.entry;
+    } else {
+        root->RV64GC_optimized__DOT__boot_pc = info.entry;
+    }
+    root->RV64GC_optimized__DOT__boot_x86_mode = info.x86_mode;
+
+    reset_cpu(cpu);
+    return true;
+}
@@ -24,6 +24,7 @@
 `define RV_OP_OP_32    7'b0111011
 `define RV_OP_LUI      7'b0110111
 `define RV_OP_OP_FP    7'b1010011
+`define RV_OP_V        7'b1010111  // Vector arithmetic and vsetvli
 `define RV_OP_SYSTEM   7'b1110011
 
 // RISC-V Funct3 for I-type instructions
@@ -51,6 +52,21 @@
 `define RV_FUNCT7_ALT    7'b0100000  // SUB, SRA
 `define RV_FUNCT7_MULDIV 7'b0000001  // RV64M operations
 
+// RISC-V V subset: VLEN = `VEC_VLEN, LMUL = 1, unmasked (vm = 1) only
+`define RV_FUNCT3_OPIVV 3'b000  // vector-vector, integer
+`define RV_FUNCT3_OPMVV 3'b010  // vector-vector, multiply class
+`define RV_FUNCT3_OPIVX 3'b100  // vector-scalar, integer
+`define RV_FUNCT3_OPMVX 3'b110  // vector-scalar, multiply class
+`define RV_FUNCT3_OPCFG 3'b111  // vsetvli (instr[31] = 0)
+`define RV_FUNCT6_VADD  6'b000000
+`define RV_FUNCT6_VMUL  6'b100101
+
+// vle/vse: LOAD-FP/STORE-FP with a vector width in funct3 (unit stride, nf = 0)
+`define RV_VWIDTH_8    3'b000
+`define RV_VWIDTH_16   3'b101
+`define RV_VWIDTH_32   3'b110
+`define RV_VWIDTH_64   3'b111
+
 // ALU Operations (internal)
 `define ALU_ADD  4'b0000
 `define ALU_SUB  4'b0001
@@ -66,6 +82,31 @@
 `define ALU_DIV  4'b1011
 `define ALU_REM  4'b1100
 
+// Performance counter classes (index into perf_class_retired)
+`define PERF_CLASS_RV_ALU_IMM     4'd0
+`define PERF_CLASS_RV_ALU_REG     4'd1
+`define PERF_CLASS_RV_MULDIV      4'd2
+`define PERF_CLASS_RV_SYSTEM      4'd3  // 0xDEADBEEF hand-off and WFI
+`define PERF_CLASS_RV_BRANCH      4'd4  // Conditional branches
+`define PERF_CLASS_RV_JUMP        4'd5  // JAL/JALR
+`define PERF_CLASS_RV_LOAD        4'd6
+`define PERF_CLASS_RV_STORE       4'd7
+
+// RISC-V Funct3 for branches
+`define RV_FUNCT3_BEQ  3'b000
+`define RV_FUNCT3_BNE  3'b001
+`define RV_FUNCT3_BLT  3'b100
+`define RV_FUNCT3_BGE  3'b101
+`define RV_FUNCT3_BLTU 3'b110
+`define RV_FUNCT3_BGEU 3'b111
+
+// Branch predictor schemes (hybrid_rv_core BP_SCHEME parameter)
+`define BP_STATIC  0  // Backward taken, forward not taken
+`define BP_BIMODAL 1  // 2-bit counters indexed by PC
+`define BP_GSHARE  2  // 2-bit counters indexed by PC xor global history
+
 // FAST Special Instructions
+`define RV_MODE_SWITCH      32'hDEADBEEF  // Start the x86 core at pc+4
+`define RV_WFI              32'h10500073  // Park the core (no interrupt sources: until reset)
 `define FASTBOY_MODE_SWITCH 32'hFASTBOY1  // Magic mode switch instruction
 `define FASTBOY_RESET       32'hFASTBOY0  // Reset to RISC-V mode
@@ -0,0 +1,21 @@
+// FAST SIMD Constants
+// Packed-integer vector unit (hybrid_simd_alu) shared by the RISC-V V subset
+// and the x86 SSE subset
+
+// Register width
+`define VEC_VLEN      128  // Bits per vector / xmm register
+`define VEC_VLENB     16   // Bytes per vector register
+
+// Utilization counters split the datapath into 32-bit lanes
+`define VEC_LANE_BITS 32
+`define VEC_LANES     4
+
+// Element width (RISC-V vsew encoding; log2 of the element bytes)
+`define VEC_SEW_8   2'd0
+`define VEC_SEW_16  2'd1
+`define VEC_SEW_32  2'd2
+`define VEC_SEW_64  2'd3
+
+// Element operations
+`define VEC_OP_ADD  2'd0  // Wrapping add (vadd, PADDQ)
+`define VEC_OP_MUL  2'd1  // Low half of the product (vmul, PMULLD)
@@ -0,0 +1,41 @@
+// FAST Hybrid CPU - lock-free single-producer/single-consumer snapshot buffer
+// Triple buffer: the producer always has a slot to write, the consumer always
+// has a stable slot to read, and the third slot is handed over with one atomic
+// exchange. Neither side ever blocks or waits on the other.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+template <typename T>
+class SnapshotBuffer {
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH_BIT = 0x4;
+
+    T slots[3];
+    alignas(64) std::atomic<uint8_t> middle; // Hand-off slot index | FRESH_BIT
+    alignas(64) uint8_t back;                // Owned by the producer
+    alignas(64) uint8_t front;               // Owned by the consumer
+
+public:
+    SnapshotBuffer() : slots(), middle(1), back(0), front(2) {}
+
+    // Producer: fill write_slot(), then publish() it
+    T& write_slot() { return slots[back]; }
+
+    void publish() {
+        back = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer: pick up the newest published snapshot, if any. Returns false
+    // (and keeps the previous snapshot) when nothing new was published.
+    bool refresh() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& latest() const { return slots[front]; }
+};
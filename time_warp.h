@@ -0,0 +1,387 @@
+// FAST Hybrid CPU - time warp
+// Drop-in for run_cycles() that fast-forwards stretches in which the model
+// only counts, and leaves every counter where cycle-by-cycle simulation would:
+//  - Idle: every enabled core is parked in WFI/HLT, the console UART has
+//    drained and neither L1 has a refill in flight. Only the cycle and idle
+//    counters and the caches' LFSRs move, so n cycles are a few additions
+//    plus a constant-time LFSR jump.
+//  - NOP sled: one core streams through L1I lines of side-effect-free words
+//    (RISC-V NOP or 0, x86 one-byte ops other than HLT) while the other is
+//    parked or off. Every line then costs the same cycles and counter
+//    increments. Once consecutive lines repeat the same period and the L1I
+//    holds exactly the sled's last lines, the warp jumps a whole number of
+//    cache capacities over lines with the same bytes: counters advance by the
+//    period per line, PC/RIP and the cached tags move with the sled, and every
+//    set, LRU rank and FIFO pointer lands where the real run would leave it.
+// Anything that could store, switch modes or wake a core ends a warp before it
+// starts: such words fail the sled content check, and nothing wakes a parked
+// core early (there are no interrupt sources). GuestMemory's host TLB
+// statistics and the trace port are not replayed, so traced runs do not warp.
+
+#pragma once
+
+#include "hybrid_model.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// L1I replacement policy whose victims depend on the LFSR (mirror mem_constants.vh)
+static const unsigned CACHE_REPL_RANDOM = 2;
+
+// Internal RTL state the warp reads or moves (public_flat / public_flat_rw)
+inline auto& rtl_rv_fetch_pc(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__rv_core__DOT__fetch_pc; }
+inline auto& rtl_l1i_valid(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__valid; }
+inline auto& rtl_l1i_tags(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__tags; }
+inline auto& rtl_l1i_fill_line(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__fill_line; }
+inline auto& rtl_l1i_fill_busy(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__fill_busy; }
+inline auto& rtl_l1i_lfsr(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__lfsr; }
+inline auto& rtl_l1d_lfsr(VRV64GC_optimized* cpu) { return cpu->rootp->RV64GC_optimized__DOT__mem__DOT__l1d__DOT__lfsr; }
+
+// One LFSR step is linear over GF(2), so a 16x16 bit matrix (one column per
+// input bit) applies it; jump[k] holds the step matrix raised to 2^k
+struct LfsrJumps {
+    uint16_t jump[16][16];
+
+    LfsrJumps() {
+        for (int bit = 0; bit < 16; bit++) {
+            uint16_t lfsr = static_cast<uint16_t>(1u << bit);
+            jump[0][bit] = static_cast<uint16_t>(lfsr << 1 | ((lfsr >> 15 ^ lfsr >> 13 ^ lfsr >> 12 ^ lfsr >> 10) & 1));
+        }
+        for (int k = 1; k < 16; k++) {
+            for (int bit = 0; bit < 16; bit++) jump[k][bit] = apply(jump[k - 1], jump[k - 1][bit]);
+        }
+    }
+
+    static uint16_t apply(const uint16_t (&matrix)[16], uint16_t lfsr) {
+        uint16_t out = 0;
+        for (int bit = 0; bit < 16; bit++) {
+            if (lfsr >> bit & 1) out ^= matrix[bit];
+        }
+        return out;
+    }
+};
+
+// hybrid_cache.v's 16-bit LFSR after `cycles` more steps (period 2^16 - 1),
+// in at most 16 matrix products whatever the distance
+inline uint16_t lfsr_advance(uint16_t lfsr, uint64_t cycles) {
+    static const LfsrJumps jumps;
+    uint64_t steps = cycles % 65535;
+    for (int k = 0; steps; k++, steps >>= 1) {
+        if (steps & 1) lfsr = LfsrJumps::apply(jumps.jump[k], lfsr);
+    }
+    return lfsr;
+}
+
+class TimeWarp {
+public:
+    explicit TimeWarp(VRV64GC_optimized* model) : cpu(model) {
+        auto* root = cpu->rootp;
+        counters = {
+            &cpu->mcycle,
+            &root->RV64GC_optimized__DOT__rv_core__DOT__mcycle,
+            &root->RV64GC_optimized__DOT__rv_core__DOT__minstret,
+            &root->RV64GC_optimized__DOT__rv_core__DOT__unknown_skips,
+            &root->RV64GC_optimized__DOT__rv_core__DOT__idle_cycles,
+            &root->RV64GC_optimized__DOT__x86_core__DOT__mcycle,
+            &root->RV64GC_optimized__DOT__x86_core__DOT__minstret,
+            &root->RV64GC_optimized__DOT__x86_core__DOT__unknown_skips,
+            &root->RV64GC_optimized__DOT__x86_core__DOT__idle_cycles,
+            &root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__hits,
+            &root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__misses,
+            &root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__evictions,
+        };
+        for (int i = 0; i < PERF_CLASS_COUNT / 2; i++) {
+            counters.push_back(&root->RV64GC_optimized__DOT__rv_core__DOT__perf_class_retired[i]);
+            counters.push_back(&root->RV64GC_optimized__DOT__x86_core__DOT__perf_class_retired[i]);
+        }
+        reset();
+    }
+
+    // Forget the sled history; call after a reset, restore or program load
+    void reset() {
+        have_mark = false;
+        in_refill = false;
+        sled_ready = false;
+        steady = 0;
+    }
+
+    // Same result as run_cycles(cpu, cycles)
+    void run(uint64_t cycles) {
+        while (cycles) {
+            cycles -= warp(cycles);
+            if (!cycles) break;
+            tick(cpu);
+            cycles--;
+            observe();
+        }
+    }
+
+    uint64_t warps() const { return warp_count; }
+    uint64_t idle_cycles() const { return idle_warped; }  // Skipped with every core parked
+    uint64_t sled_cycles() const { return sled_warped; }  // Skipped inside NOP sleds
+    uint64_t warped_cycles() const { return idle_warped + sled_warped; }
+
+private:
+    // Sleds must repeat the same period this many times before a warp
+    static const uint64_t STEADY_PERIODS = 2;
+
+    enum { COUNTER_MCYCLE = 0, COUNTER_L1I_MISSES = 10 }; // Indices into counters
+
+    // State at the first cycle of a sled-line refill: the fetching core waits
+    // for line `line` with nothing else in flight
+    struct Mark {
+        bool x86;
+        uint64_t line;
+        uint64_t fill_count;
+        uint64_t waited;
+        std::vector<uint64_t> counters;
+        PerfCounters quiet; // side_effects() of the counters
+    };
+
+    VRV64GC_optimized* cpu;
+    std::vector<uint64_t*> counters; // Every counter a warp advances
+    Mark last;
+    bool have_mark;
+    bool in_refill;
+    bool sled_ready;
+    uint64_t steady;                // Consecutive periods equal to `period`
+    std::vector<uint64_t> period;   // Counter increments from one mark to the next
+    uint64_t warp_count = 0;
+    uint64_t idle_warped = 0;
+    uint64_t sled_warped = 0;
+
+    // The counters a warp does not advance: they must not move inside a sled
+    static PerfCounters side_effects(PerfCounters perf) {
+        perf.mcycle = perf.minstret = 0;
+        perf.rv_mcycle = perf.rv_minstret = perf.x86_mcycle = perf.x86_minstret = 0;
+        perf.unknown_skips = perf.rv_idle_cycles = perf.x86_idle_cycles = 0;
+        perf.l1i_hits = perf.l1i_misses = perf.l1i_evictions = 0;
+        std::fill(std::begin(perf.class_retired), std::end(perf.class_retired), 0);
+        return perf;
+    }
+
+    // Cycles skipped (0 = tick normally)
+    uint64_t warp(uint64_t budget) {
+        if (parked()) {
+            skip_idle(budget);
+            return budget;
+        }
+        if (!sled_ready) return 0;
+        sled_ready = false;
+        return skip_sled(budget);
+    }
+
+    // Nothing outside the cores still moving on its own: the UART has sent
+    // every byte and no L1D refill is in flight. Neither is replayed by a warp
+    bool devices_quiet() const {
+        auto* root = cpu->rootp;
+        return !root->RV64GC_optimized__DOT__mem__DOT__uart__DOT__count &&
+               !root->RV64GC_optimized__DOT__mem__DOT__uart__DOT__tx_timer &&
+               !root->RV64GC_optimized__DOT__mem__DOT__l1d__DOT__fill_busy;
+    }
+
+    // === IDLE ===
+    bool parked() const {
+        auto* root = cpu->rootp;
+        return (!root->RV64GC_optimized__DOT__rv_mode_active || cpu->rv_idle) &&
+               (!root->RV64GC_optimized__DOT__x86_mode_active || cpu->x86_idle) &&
+               devices_quiet() && !rtl_l1i_fill_busy(cpu);
+    }
+
+    void skip_idle(uint64_t cycles) {
+        auto* root = cpu->rootp;
+        cpu->mcycle += cycles;
+        if (root->RV64GC_optimized__DOT__rv_mode_active) {
+            root->RV64GC_optimized__DOT__rv_core__DOT__mcycle += cycles;
+            root->RV64GC_optimized__DOT__rv_core__DOT__idle_cycles += cycles;
+        }
+        if (root->RV64GC_optimized__DOT__x86_mode_active) {
+            root->RV64GC_optimized__DOT__x86_core__DOT__mcycle += cycles;
+            root->RV64GC_optimized__DOT__x86_core__DOT__idle_cycles += cycles;
+        }
+        advance_lfsrs(cycles);
+        cpu->eval();
+        warp_count++;
+        idle_warped += cycles;
+    }
+
+    void advance_lfsrs(uint64_t cycles) {
+        rtl_l1i_lfsr(cpu) = lfsr_advance(rtl_l1i_lfsr(cpu), cycles);
+        rtl_l1d_lfsr(cpu) = lfsr_advance(rtl_l1d_lfsr(cpu), cycles);
+    }
+
+    // === NOP SLED ===
+    // After every real cycle: mark the first cycle of each refill the
+    // streaming core waits on (RISC-V: once its pipeline has drained)
+    void observe() {
+        auto* root = cpu->rootp;
+        bool rv_run = root->RV64GC_optimized__DOT__rv_mode_active && !cpu->rv_idle;
+        bool x86_run = root->RV64GC_optimized__DOT__x86_mode_active && !cpu->x86_idle;
+        uint64_t line_bytes = cpu->l1i_line_bytes;
+        if (rv_run == x86_run || !line_bytes) { // Both cores stream, or none does
+            reset();
+            return;
+        }
+
+        uint64_t addr = x86_run ? root->RV64GC_optimized__DOT__x86_core__DOT__x86_rip : rtl_rv_fetch_pc(cpu);
+        bool drained = x86_run || !(root->RV64GC_optimized__DOT__rv_core__DOT__if_id_valid ||
+                                    root->RV64GC_optimized__DOT__rv_core__DOT__id_ex_valid ||
+                                    root->RV64GC_optimized__DOT__rv_core__DOT__ex_mem_valid ||
+                                    root->RV64GC_optimized__DOT__rv_core__DOT__mem_wb_valid);
+        bool refill = drained && addr % line_bytes == 0 && rtl_l1i_fill_busy(cpu) &&
+                      rtl_l1i_fill_line(cpu) == addr / line_bytes;
+        if (!refill) {
+            in_refill = false;
+            return;
+        }
+        if (in_refill) return; // Still the refill already marked
+        in_refill = true;
+        mark(x86_run, addr / line_bytes);
+    }
+
+    void mark(bool x86, uint64_t line) {
+        auto* root = cpu->rootp;
+        Mark next;
+        next.x86 = x86;
+        next.line = line;
+        next.fill_count = root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__fill_count;
+        next.waited = root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__waited;
+        for (uint64_t* counter : counters) next.counters.push_back(*counter);
+        next.quiet = side_effects(capture_counters(cpu));
+
+        // One line on from the last mark, in the same phase and without side effects
+        bool follows = have_mark && x86 == last.x86 && line == last.line + 1 &&
+                       next.counters[COUNTER_MCYCLE] > last.counters[COUNTER_MCYCLE] &&
+                       next.fill_count == last.fill_count && next.waited == last.waited &&
+                       !memcmp(&next.quiet, &last.quiet, sizeof(PerfCounters));
+        std::vector<uint64_t> delta(counters.size());
+        if (follows) {
+            for (size_t i = 0; i < counters.size(); i++) delta[i] = next.counters[i] - last.counters[i];
+        }
+        steady = follows && delta == period && delta[COUNTER_L1I_MISSES] == 1 ? steady + 1 : 0;
+        period.swap(delta);
+        last = std::move(next);
+        have_mark = true;
+        sled_ready = steady >= STEADY_PERIODS;
+    }
+
+    uint64_t skip_sled(uint64_t budget) {
+        GuestMemory* memory = attached_memory(cpu);
+        uint64_t lines = cpu->l1i_lines;
+        uint64_t line_bytes = cpu->l1i_line_bytes;
+        uint64_t period_cycles = period[COUNTER_MCYCLE];
+        if (!memory || cpu->l1i_repl == CACHE_REPL_RANDOM || cpu->mcycle != last.counters[COUNTER_MCYCLE] ||
+            last.line < std::max(lines, STEADY_PERIODS + 1)) {
+            return 0;
+        }
+        // The only refill in flight may be the marked sled line's, which moves with it
+        if (!devices_quiet() || rtl_l1i_fill_line(cpu) != last.line) return 0;
+
+        // Whole cache capacities only, so every line keeps its set and way
+        uint64_t affordable = budget / period_cycles;
+        affordable -= affordable % lines;
+        if (!affordable || !holds_sled_tail(lines)) return 0;
+
+        // The measured lines and the ones ahead must hold the same safe bytes
+        std::vector<uint8_t> pattern(line_bytes);
+        read_line(*memory, last.line - 1, pattern.data());
+        if (!safe_line(pattern, last.x86) ||
+            matching_lines(*memory, last.line - STEADY_PERIODS - 1, STEADY_PERIODS + 1, pattern) < STEADY_PERIODS + 1) {
+            return 0;
+        }
+        uint64_t skip = matching_lines(*memory, last.line, affordable, pattern);
+        skip -= skip % lines;
+        if (!skip) return 0;
+
+        auto* root = cpu->rootp;
+        uint64_t shift = skip * line_bytes;
+        for (size_t i = 0; i < counters.size(); i++) *counters[i] += skip * period[i];
+        if (last.x86) {
+            root->RV64GC_optimized__DOT__x86_core__DOT__x86_rip += shift;
+            root->RV64GC_optimized__DOT__x86_core__DOT__retire_pc += shift;
+            root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__waited_line1 += skip;
+        } else {
+            root->RV64GC_optimized__DOT__rv_core__DOT__pc += shift;
+            rtl_rv_fetch_pc(cpu) += shift;
+            root->RV64GC_optimized__DOT__rv_core__DOT__retire_pc += shift;
+            root->RV64GC_optimized__DOT__mem__DOT__l1i__DOT__waited_line0 += skip;
+        }
+        for (uint64_t i = 0; i < lines; i++) rtl_l1i_tags(cpu)[i] += skip;
+        rtl_l1i_fill_line(cpu) += skip;
+        advance_lfsrs(skip * period_cycles);
+        cpu->eval();
+
+        // The sled goes on from the moved mark
+        last.line += skip;
+        for (size_t i = 0; i < counters.size(); i++) last.counters[i] += skip * period[i];
+        warp_count++;
+        sled_warped += skip * period_cycles;
+        return skip * period_cycles;
+    }
+
+    // Every L1I entry is valid and the entries are exactly the `lines` lines
+    // before the marked one (so no older line is left to evict)
+    bool holds_sled_tail(uint64_t lines) {
+        uint64_t first = last.line - lines;
+        std::vector<bool> seen(lines);
+        for (uint64_t i = 0; i < lines; i++) {
+            uint64_t tag = rtl_l1i_tags(cpu)[i];
+            if (!rtl_l1i_valid(cpu)[i] || tag < first || tag >= last.line || seen[tag - first]) return false;
+            seen[tag - first] = true;
+        }
+        return true;
+    }
+
+    // Words that retire or skip without touching anything but PC/RIP: RISC-V
+    // NOP or 0 (skipped); x86 bytes other than REX.W, the SSE prefixes and HLT
+    // (the core decodes byte 0 of each aligned word, one byte at a time)
+    static bool safe_line(const std::vector<uint8_t>& bytes, bool x86) {
+        for (size_t i = 0; i + 4 <= bytes.size(); i += 4) {
+            uint32_t word;
+            memcpy(&word, &bytes[i], sizeof(word));
+            if (x86) {
+                uint8_t op = word & 0xFF;
+                if (op == 0x48 || op == 0x66 || op == 0xF3 || op == 0xF4) return false;
+            } else if (word != 0x00000013 && word != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Lines never cross a page; unmapped pages read as zero
+    void read_line(const GuestMemory& memory, uint64_t line, uint8_t* out) const {
+        uint64_t line_bytes = cpu->l1i_line_bytes;
+        uint64_t addr = line * line_bytes;
+        const uint8_t* page = memory.find_page(addr);
+        if (page) memcpy(out, page + (addr & (memory.page_bytes() - 1)), line_bytes);
+        else memset(out, 0, line_bytes);
+    }
+
+    // How many of the `count` lines from `line` on hold `pattern`; an
+    // unmapped page is checked in one step
+    uint64_t matching_lines(const GuestMemory& memory, uint64_t line, uint64_t count,
+                            const std::vector<uint8_t>& pattern) const {
+        uint64_t line_bytes = pattern.size();
+        uint64_t page_bytes = memory.page_bytes();
+        bool zero = std::all_of(pattern.begin(), pattern.end(), [](uint8_t b) { return b == 0; });
+        uint64_t n = 0;
+        while (n < count) {
+            uint64_t addr = (line + n) * line_bytes;
+            uint64_t offset = addr & (page_bytes - 1);
+            uint64_t span = std::min((page_bytes - offset) / line_bytes, count - n);
+            const uint8_t* page = memory.find_page(addr);
+            if (!page) {
+                if (!zero) return n;
+                n += span;
+                continue;
+            }
+            for (uint64_t i = 0; i < span; i++) {
+                if (memcmp(page + offset + i * line_bytes, pattern.data(), line_bytes)) return n + i;
+            }
+            n += span;
+        }
+        return n;
+    }
+};
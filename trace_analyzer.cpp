@@ -0,0 +1,265 @@
+// FAST Hybrid CPU - offline trace analyzer
+// Memory-maps a retired-instruction trace (see instr_trace.h), decompresses it
+// chunk by chunk and prints instruction-mix, hot-PC and mode-switch reports.
+//
+// Usage: trace_analyzer [--top N] <trace-file>
+
+#include "instr_trace.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Mnemonic for the subset the RTL retires
+static const char* mnemonic(uint32_t instr, bool x86) {
+    if (x86) {
+        if ((instr & 0xFF) == 0x90) return "NOP";
+        if ((instr & 0xFF) == 0xF4) return "HLT";
+        if ((instr & 0xFFFF) == 0x0F66 && ((instr >> 16) & 0xFF) == 0xD4) return "PADDQ xmm, xmm";
+        if ((instr & 0xFFFF) == 0x0F66 && ((instr >> 16) & 0xFF) == 0x38) return "PMULLD xmm, xmm";
+        if ((instr & 0xFFFF) == 0x0FF3 && ((instr >> 16) & 0xFF) == 0x6F) return "MOVDQU xmm, m128";
+        if ((instr & 0xFFFF) == 0x0FF3 && ((instr >> 16) & 0xFF) == 0x7F) return "MOVDQU m128, xmm";
+        if ((instr & 0xFF) != 0x48) return "x86 (other)";
+        switch ((instr >> 8) & 0xFF) {
+            case 0xC7: return "MOV r64, imm";
+            case 0x01: return "ADD r64, r64";
+            case 0xB0: return "MOV AL, imm8";
+            case 0xE6: return "OUT imm8, AL";
+            default: return "REX.W (other)";
+        }
+    }
+    if (instr == 0xDEADBEEF) return "MODE_SWITCH";
+    if (instr == 0x10500073) return "WFI";
+    uint32_t funct3 = (instr >> 12) & 0x7;
+    uint32_t funct7 = instr >> 25;
+    switch (instr & 0x7F) {
+        case 0x13:
+            if (instr == 0x00000013) return "NOP (addi x0)";
+            if (funct3 == 0) return "ADDI";
+            if (funct3 == 4) return "XORI";
+            return "OP-IMM (other)";
+        case 0x33:
+            if (funct7 == 0x01 && funct3 == 0) return "MUL";
+            if (funct7 == 0x00 && funct3 == 0) return "ADD";
+            if (funct7 == 0x00 && funct3 == 4) return "XOR";
+            return "OP (other)";
+        case 0x1B:
+        case 0x3B: return "OP-32 (*W)";
+        case 0x37: return "LUI";
+        case 0x17: return "AUIPC";
+        case 0x6F: return "JAL";
+        case 0x67: return "JALR";
+        case 0x63: return "BRANCH";
+        case 0x03: return "LOAD";
+        case 0x23: return "STORE";
+        case 0x57:
+            if (funct3 == 7) return "VSETVLI";
+            if ((instr >> 26) == 0x25) return funct3 == 6 ? "VMUL.VX" : "VMUL.VV";
+            return funct3 == 4 ? "VADD.VX" : "VADD.VV";
+        case 0x07: return "VLE";
+        case 0x27: return "VSE";
+        default:
+            return "RISC-V (other)";
+    }
+}
+
+// RISC-V and x86 address spaces are kept apart with the top key bit
+static const uint64_t X86_PC_KEY = 1ULL << 63;
+
+struct PcStats {
+    uint64_t count = 0;
+    uint32_t instr = 0;
+    bool x86 = false;
+};
+
+struct ModeSwitch {
+    uint64_t record;
+    uint64_t pc;
+    bool to_x86;
+};
+
+class TraceAnalyzer {
+private:
+    uint64_t records = 0;
+    uint64_t chunks = 0;
+    uint64_t raw_bytes = 0;
+    uint64_t compressed_bytes = 0;
+    uint64_t writes = 0;
+    std::map<const char*, uint64_t> mix; // Keyed by the static mnemonic strings
+    std::unordered_map<uint64_t, PcStats> pcs;
+    std::vector<ModeSwitch> switches;
+    uint64_t mode_records[2] = {0, 0};
+    uint64_t mode_runs[2] = {0, 0};
+
+public:
+    bool analyze(const MappedFile& file, std::string& error) {
+        const uint8_t* p = file.bytes();
+        const uint8_t* end = p + file.size();
+
+        TraceFileHeader header;
+        if (file.size() < sizeof(header)) {
+            error = "file too small for a trace header";
+            return false;
+        }
+        memcpy(&header, p, sizeof(header));
+        if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+            error = "not a hybridcpu64 trace (or unsupported version)";
+            return false;
+        }
+        p += sizeof(header);
+
+        std::vector<uint8_t> raw(header.chunk_bytes);
+        bool have_last = false;
+        bool last_x86 = false;
+
+        while (p < end) {
+            TraceChunkHeader chunk;
+            if (static_cast<size_t>(end - p) < sizeof(chunk)) {
+                error = "truncated chunk header";
+                return false;
+            }
+            memcpy(&chunk, p, sizeof(chunk));
+            p += sizeof(chunk);
+            if (chunk.compressed_bytes > static_cast<size_t>(end - p) || chunk.raw_bytes > raw.size()) {
+                error = "truncated or oversized chunk";
+                return false;
+            }
+
+            uLongf length = chunk.raw_bytes;
+            if (uncompress(raw.data(), &length, p, chunk.compressed_bytes) != Z_OK || length != chunk.raw_bytes) {
+                error = "corrupt chunk " + std::to_string(chunks);
+                return false;
+            }
+            p += chunk.compressed_bytes;
+            chunks++;
+            raw_bytes += chunk.raw_bytes;
+            compressed_bytes += sizeof(chunk) + chunk.compressed_bytes;
+
+            // Each chunk starts from a fresh decoder state
+            TraceDecoder decoder;
+            const uint8_t* q = raw.data();
+            const uint8_t* q_end = q + length;
+            TraceRecord r;
+            for (uint32_t i = 0; i < chunk.records; i++) {
+                if (!decoder.decode(q, q_end, r)) {
+                    error = "truncated record in chunk " + std::to_string(chunks - 1);
+                    return false;
+                }
+                if (have_last && r.x86 != last_x86) switches.push_back({records, r.pc, r.x86});
+                if (!have_last || r.x86 != last_x86) mode_runs[r.x86]++;
+                have_last = true;
+                last_x86 = r.x86;
+                add(r);
+            }
+        }
+        return true;
+    }
+
+    void report(size_t top) const {
+        printf("📄 %" PRIu64 " records in %" PRIu64 " chunks: %" PRIu64 " bytes encoded, %" PRIu64
+               " on disk (%.2f bytes/record)\n",
+               records, chunks, raw_bytes, compressed_bytes,
+               records ? static_cast<double>(compressed_bytes) / records : 0.0);
+        printf("   RISC-V %" PRIu64 " / x86 %" PRIu64 " records, %" PRIu64 " register writes\n\n",
+               mode_records[0], mode_records[1], writes);
+
+        // Instruction mix, most frequent first
+        std::vector<std::pair<const char*, uint64_t>> sorted_mix(mix.begin(), mix.end());
+        std::sort(sorted_mix.begin(), sorted_mix.end(),
+                  [](const std::pair<const char*, uint64_t>& a, const std::pair<const char*, uint64_t>& b) {
+                      return a.second > b.second;
+                  });
+        printf("🧮 Instruction mix\n");
+        for (const auto& entry : sorted_mix) {
+            printf("   %-18s %12" PRIu64 "  %6.2f%%\n", entry.first, entry.second, percent(entry.second));
+        }
+
+        // Hot PCs
+        std::vector<std::pair<uint64_t, PcStats>> hot(pcs.begin(), pcs.end());
+        size_t shown = std::min(top, hot.size());
+        std::partial_sort(hot.begin(), hot.begin() + shown, hot.end(),
+                          [](const std::pair<uint64_t, PcStats>& a, const std::pair<uint64_t, PcStats>& b) {
+                              return a.second.count > b.second.count;
+                          });
+        printf("\n🔥 Hot PCs (top %zu of %zu)\n", shown, hot.size());
+        for (size_t i = 0; i < shown; i++) {
+            const PcStats& s = hot[i].second;
+            printf("   %s 0x%016" PRIx64 "  %12" PRIu64 "  %6.2f%%  %08x  %s\n",
+                   s.x86 ? "RIP" : "PC ", hot[i].first & ~X86_PC_KEY, s.count, percent(s.count),
+                   s.instr, mnemonic(s.instr, s.x86));
+        }
+
+        // Mode switches
+        printf("\n🔄 Mode switches: %zu\n", switches.size());
+        for (size_t i = 0; i < switches.size() && i < top; i++) {
+            printf("   record %12" PRIu64 "  → %-6s at 0x%016" PRIx64 "\n", switches[i].record,
+                   switches[i].to_x86 ? "x86" : "RISC-V", switches[i].pc);
+        }
+        if (switches.size() > top) printf("   ... %zu more\n", switches.size() - top);
+        printf("   average run length: RISC-V %.1f, x86 %.1f records\n",
+               mode_runs[0] ? static_cast<double>(mode_records[0]) / mode_runs[0] : 0.0,
+               mode_runs[1] ? static_cast<double>(mode_records[1]) / mode_runs[1] : 0.0);
+    }
+
+private:
+    void add(const TraceRecord& r) {
+        records++;
+        mode_records[r.x86]++;
+        if (r.write) writes++;
+        mix[mnemonic(r.instr, r.x86)]++;
+
+        PcStats& s = pcs[r.pc | (r.x86 ? X86_PC_KEY : 0)];
+        s.count++;
+        s.instr = r.instr;
+        s.x86 = r.x86;
+    }
+
+    double percent(uint64_t n) const { return records ? 100.0 * n / records : 0.0; }
+};
+
+static void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--top N] <trace-file>\n";
+}
+
+int main(int argc, char **argv) {
+    size_t top = 20;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--top") && i + 1 < argc) {
+            top = strtoul(argv[++i], nullptr, 10);
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    MappedFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        std::cerr << "❌ " << error << "\n";
+        return 1;
+    }
+
+    TraceAnalyzer analyzer;
+    if (!analyzer.analyze(file, error)) {
+        std::cerr << "❌ " << path << ": " << error << "\n";
+        return 1;
+    }
+    analyzer.report(top);
+    return 0;
+}
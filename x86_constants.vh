@@ -39,11 +39,23 @@
 `define X86_OP_NOP       8'h90    // NOP
 `define X86_OP_PUSH_REG  8'h50    // PUSH r (+ reg in low 3 bits)
 `define X86_OP_POP_REG   8'h58    // POP r (+ reg in low 3 bits)
+`define X86_OP_MOV_AL_IMM 8'hB0   // MOV AL, imm8
+`define X86_OP_OUT_IMM   8'hE6    // OUT imm8, AL (port = console register offset)
+`define X86_OP_HLT       8'hF4    // HLT: park until the next start (0xDEADBEEF)
 
 // x86 Prefixes
 `define X86_PREFIX_REX_W 8'h48    // REX.W (64-bit operand)
 `define X86_PREFIX_LOCK  8'hF0    // LOCK prefix
-`define X86_PREFIX_REP   8'hF3    // REP prefix
+`define X86_PREFIX_REP   8'hF3    // REP prefix (MOVDQU mandatory prefix)
+`define X86_PREFIX_OPSZ  8'h66    // Operand size (SSE2 packed-integer mandatory prefix)
+
+// SSE packed-integer opcodes (after the mandatory prefix and 0F escape)
+`define X86_OP_ESCAPE     8'h0F
+`define X86_OP_ESCAPE_38  8'h38   // 0F 38 three-byte map
+`define X86_OP_PADDQ      8'hD4   // 66 0F D4 /r    PADDQ xmm, xmm
+`define X86_OP_PMULLD     8'h40   // 66 0F 38 40 /r PMULLD xmm, xmm
+`define X86_OP_MOVDQU_LD  8'h6F   // F3 0F 6F /r    MOVDQU xmm, xmm/[reg]
+`define X86_OP_MOVDQU_ST  8'h7F   // F3 0F 7F /r    MOVDQU [reg], xmm
 
 // x86 ModR/M byte fields
 `define X86_MOD_REG      2'b11    // Register addressing
@@ -71,5 +83,12 @@
 `define X86_ADDR_DISP    2'b10    // Memory + displacement
 `define X86_ADDR_IMM     2'b11    // Immediate
 
+// Performance counter classes (index into perf_class_retired, after the RISC-V ones)
+`define PERF_CLASS_X86_ALU  4'd8
+`define PERF_CLASS_X86_NOP  4'd9
+`define PERF_CLASS_X86_IO   4'd10
+`define PERF_CLASS_X86_SIMD 4'd11
+`define PERF_CLASS_X86_HALT 4'd12
+
 // FAST x86 Magic Values
 `define X86_FASTBOY_SIG  64'hFASTB01234567890  // FAST signature in RAX